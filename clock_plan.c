@@ -0,0 +1,146 @@
+/**
+ * System clock and PIO dividers, see clock_plan.h.
+ */
+#include "clock_plan.h"
+
+#define VCO_MIN_HZ 750000000u
+#define VCO_MAX_HZ 1600000000u
+#define FBDIV_MIN 16
+#define FBDIV_MAX 320
+#define POSTDIV_MAX 7
+
+// Divider in 1/256 closest to sys / target, within the 1.0 - 65535.996 range of the PIO.
+static uint32_t closest_divider(uint32_t vco_hz, uint32_t postdiv, uint64_t target_mhz)
+{
+    // sys in mHz * 256 over the target, rounded.
+    const uint64_t numerator = (uint64_t)vco_hz * 1000 * 256;
+    const uint64_t denominator = (uint64_t)postdiv * target_mhz;
+    uint64_t div256 = (numerator + denominator / 2) / denominator;
+    if (div256 < 256)
+    {
+        div256 = 256;
+    }
+    if (div256 > 0xffffff)
+    {
+        div256 = 0xffffff;
+    }
+    return (uint32_t)div256;
+}
+
+static int32_t error_ppb(uint32_t vco_hz, uint32_t postdiv, uint32_t div256, uint64_t target_mhz)
+{
+    const uint64_t achieved_mhz = (uint64_t)vco_hz * 1000 * 256 / ((uint64_t)postdiv * div256);
+    const int64_t difference = (int64_t)achieved_mhz - (int64_t)target_mhz;
+    const int64_t ppb = difference * 1000000000 / (int64_t)target_mhz;
+    return (ppb > INT32_MAX) ? INT32_MAX : (ppb < -INT32_MAX) ? -INT32_MAX : (int32_t)ppb;
+}
+
+static uint32_t abs_ppb(int32_t ppb)
+{
+    return ppb < 0 ? (uint32_t)-ppb : (uint32_t)ppb;
+}
+
+// Dividers for one PLL setting into candidate, true if it beats best.
+static bool try_pll(struct clock_plan_t* candidate, const struct clock_plan_t* best, bool has_best, uint64_t csync_mhz,
+                    uint64_t rgb_mhz, uint32_t max_ppm)
+{
+    const uint32_t postdiv = candidate->postdiv1 * candidate->postdiv2;
+    const uint32_t csync_div = closest_divider(candidate->vco_hz, postdiv, csync_mhz);
+    const uint32_t rgb_div = closest_divider(candidate->vco_hz, postdiv, rgb_mhz);
+
+    candidate->sys_hz = (candidate->vco_hz + postdiv / 2) / postdiv;
+    candidate->csync_div_int = csync_div >> 8;
+    candidate->csync_div_frac = csync_div & 0xff;
+    candidate->rgb_div_int = rgb_div >> 8;
+    candidate->rgb_div_frac = rgb_div & 0xff;
+    candidate->csync_error_ppb = error_ppb(candidate->vco_hz, postdiv, csync_div, csync_mhz);
+    candidate->rgb_error_ppb = error_ppb(candidate->vco_hz, postdiv, rgb_div, rgb_mhz);
+
+    if (!has_best)
+    {
+        return true;
+    }
+
+    // Over the target, the worst of the two errors counts.
+    const uint32_t max_ppb = max_ppm * 1000;
+    uint32_t worst = abs_ppb(candidate->csync_error_ppb);
+    worst = abs_ppb(candidate->rgb_error_ppb) > worst ? abs_ppb(candidate->rgb_error_ppb) : worst;
+    uint32_t best_worst = abs_ppb(best->csync_error_ppb);
+    best_worst = abs_ppb(best->rgb_error_ppb) > best_worst ? abs_ppb(best->rgb_error_ppb) : best_worst;
+    const uint32_t over = worst > max_ppb ? worst : 0;
+    const uint32_t best_over = best_worst > max_ppb ? best_worst : 0;
+    if (over != best_over)
+    {
+        return over < best_over;
+    }
+
+    const bool even = candidate->rgb_div_frac == 0;
+    const bool best_even = best->rgb_div_frac == 0;
+    if (even != best_even)
+    {
+        return even;
+    }
+
+    if (abs_ppb(candidate->csync_error_ppb) != abs_ppb(best->csync_error_ppb))
+    {
+        return abs_ppb(candidate->csync_error_ppb) < abs_ppb(best->csync_error_ppb);
+    }
+    if (abs_ppb(candidate->rgb_error_ppb) != abs_ppb(best->rgb_error_ppb))
+    {
+        return abs_ppb(candidate->rgb_error_ppb) < abs_ppb(best->rgb_error_ppb);
+    }
+
+    // As good as it gets, the fastest CPU then.
+    return candidate->sys_hz > best->sys_hz;
+}
+
+static bool within(const struct clock_plan_t* plan, uint32_t max_ppm)
+{
+    const uint32_t max_ppb = max_ppm * 1000;
+    return abs_ppb(plan->csync_error_ppb) <= max_ppb && abs_ppb(plan->rgb_error_ppb) <= max_ppb;
+}
+
+bool clock_plan_solve(struct clock_plan_t* plan, uint64_t csync_mhz, uint64_t rgb_mhz, uint32_t min_sys_hz, uint32_t max_sys_hz,
+                      uint32_t max_ppm)
+{
+    bool has_best = false;
+
+    // Lowest VCO first, it draws less power, a higher one only wins by being more accurate or faster.
+    for (uint32_t fbdiv = FBDIV_MIN; fbdiv <= FBDIV_MAX; fbdiv++)
+    {
+        const uint32_t vco_hz = CLOCK_PLAN_XOSC_HZ * fbdiv;
+        if (vco_hz < VCO_MIN_HZ || vco_hz > VCO_MAX_HZ)
+        {
+            continue;
+        }
+
+        for (uint32_t postdiv1 = 1; postdiv1 <= POSTDIV_MAX; postdiv1++)
+        {
+            for (uint32_t postdiv2 = 1; postdiv2 <= postdiv1; postdiv2++)
+            {
+                const uint64_t postdiv = postdiv1 * postdiv2;
+                if (vco_hz < min_sys_hz * postdiv || vco_hz > max_sys_hz * postdiv)
+                {
+                    continue;
+                }
+
+                struct clock_plan_t candidate = {.vco_hz = vco_hz, .postdiv1 = (uint8_t)postdiv1, .postdiv2 = (uint8_t)postdiv2};
+                if (try_pll(&candidate, plan, has_best, csync_mhz, rgb_mhz, max_ppm))
+                {
+                    *plan = candidate;
+                    has_best = true;
+                }
+            }
+        }
+    }
+
+    return has_best && within(plan, max_ppm);
+}
+
+bool clock_plan_solve_dividers(struct clock_plan_t* plan, uint64_t csync_mhz, uint64_t rgb_mhz, uint32_t max_ppm)
+{
+    struct clock_plan_t candidate = {.vco_hz = plan->vco_hz, .postdiv1 = plan->postdiv1, .postdiv2 = plan->postdiv2};
+    try_pll(&candidate, plan, false, csync_mhz, rgb_mhz, max_ppm);
+    *plan = candidate;
+    return within(plan, max_ppm);
+}
@@ -0,0 +1,51 @@
+/**
+ * System clock and PIO dividers for a video mode.
+ *
+ * The csync state machine has to run at SYNC_LINE_TICS tics per line and the rgb one at 3
+ * cycles per pixel. Both are the system clock through a 16.8 fractional divider, and the
+ * system clock is the 12 MHz crystal through the PLL (VCO 750-1600 MHz, two post dividers
+ * of 1-7), so the solver walks every PLL setting in the allowed system clock range, picks
+ * the closest dividers for each and keeps the best one:
+ *  - both frequencies within the ppm target,
+ *  - an integer rgb divider, every pixel the same width (a fractional one makes some pixels
+ *    a system clock cycle longer),
+ *  - the smallest line frequency error, it's what the monitor locks to, then pixel error,
+ *  - the fastest system clock.
+ *
+ * Plain C without the SDK so tools/pio_sim runs the very same search.
+ */
+#ifndef CLOCK_PLAN_H
+#define CLOCK_PLAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CLOCK_PLAN_XOSC_HZ 12000000
+
+struct clock_plan_t
+{
+    // PLL: sys = vco_hz / (postdiv1 * postdiv2).
+    uint32_t vco_hz;
+    uint8_t postdiv1;
+    uint8_t postdiv2;
+    uint32_t sys_hz; // Rounded, informative.
+
+    uint16_t csync_div_int;
+    uint8_t csync_div_frac;
+    uint16_t rgb_div_int;
+    uint8_t rgb_div_frac;
+
+    // Achieved error in parts per billion, positive is too fast.
+    int32_t csync_error_ppb;
+    int32_t rgb_error_ppb;
+};
+
+// Best PLL and dividers with the system clock between min_sys_hz and max_sys_hz, the targets in mHz.
+// Returns false if no setting is within max_ppm, the plan is the best one anyway.
+bool clock_plan_solve(struct clock_plan_t* plan, uint64_t csync_mhz, uint64_t rgb_mhz, uint32_t min_sys_hz, uint32_t max_sys_hz,
+                      uint32_t max_ppm);
+
+// Dividers only, keeping the PLL of the plan (to switch modes without touching the system clock).
+bool clock_plan_solve_dividers(struct clock_plan_t* plan, uint64_t csync_mhz, uint64_t rgb_mhz, uint32_t max_ppm);
+
+#endif
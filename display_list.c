@@ -0,0 +1,236 @@
+/**
+ * DMA display list, see display_list.h.
+ */
+#include "display_list.h"
+
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+static uint s_channel_0; // Transfer color
+static uint s_channel_1; // Copy the control blocks into channel 0.
+static uint s_channel_2; // Restart channel 1.
+
+static uint s_line_words;
+static io_wo_32* s_write_addr;
+
+// ctrl for the pixels and for the borders, and the same two for the last block of a list.
+static uint32_t s_ctrl_pixels;
+static uint32_t s_ctrl_border;
+static uint32_t s_ctrl_pixels_end;
+static uint32_t s_ctrl_border_end;
+
+// Channel 2 reads the head of the list from here (POINTER TO AN ADDRESS), one per field. The
+// read ring wraps every 8 bytes so it picks them in turn.
+static const volatile void* s_list_head[2] __attribute__((aligned(8)));
+
+static void (*s_frame_callback)(void);
+
+static void dma_irq_handler(void)
+{
+    dma_hw->ints0 = 1u << s_channel_0;
+
+    if (s_frame_callback)
+    {
+        s_frame_callback();
+    }
+}
+
+void display_list_init(PIO pio, uint sm, uint line_bytes)
+{
+    hard_assert((line_bytes & 3) == 0);
+    s_line_words = line_bytes >> 2;
+    s_write_addr = &pio->txf[sm];
+
+    s_channel_0 = dma_claim_unused_channel(true);
+    s_channel_1 = dma_claim_unused_channel(true);
+    s_channel_2 = dma_claim_unused_channel(true);
+
+    {
+        // Transfer colors to the PIO SM, which autopulls 32 bits (8 pixels) at a time.
+        dma_channel_config cfg = dma_channel_get_default_config(s_channel_0); // default configs
+        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);			  // 32-bit txfers
+        channel_config_set_read_increment(&cfg, true);						  // yes read incrementing
+        channel_config_set_write_increment(&cfg, false);					  // no write incrementing
+        channel_config_set_dreq(&cfg, pio_get_dreq(pio, sm, true));			  // DREQ_PIO0_TX2 pacing (FIFO)
+        channel_config_set_irq_quiet(&cfg, true);
+        channel_config_set_chain_to(&cfg, s_channel_1);
+
+        // ctrl for the pixels.
+        s_ctrl_pixels = cfg.ctrl;
+
+        // ctrl for the borders, the color is always the same so no read increment.
+        channel_config_set_read_increment(&cfg, false);
+        s_ctrl_border = cfg.ctrl;
+
+        // for the last block set the chain to channel 2 to restart the list once transfering finishes,
+        // and raise an irq when it is done.
+        channel_config_set_chain_to(&cfg, s_channel_2);
+        channel_config_set_irq_quiet(&cfg, false);
+        s_ctrl_border_end = cfg.ctrl;
+
+        channel_config_set_read_increment(&cfg, true);
+        s_ctrl_pixels_end = cfg.ctrl;
+    }
+
+    {
+        // DMA channel 1 configure dma 0 (aka RGB data).
+        dma_channel_config cfg = dma_channel_get_default_config(s_channel_1);
+        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+        channel_config_set_read_increment(&cfg, true);
+        channel_config_set_write_increment(&cfg, true);
+        channel_config_set_ring(&cfg, true, 4); // 16 byte boundary on write ptr
+        channel_config_set_irq_quiet(&cfg, true);
+
+        dma_channel_configure(s_channel_1,
+                              &cfg,
+                              &dma_hw->ch[s_channel_0].al1_ctrl, // Initial write address
+                              NULL,								 // Read address, set by channel 2
+                              4,								 // Halt after each control block
+                              false								 // Don't start yet
+        );
+    }
+
+    {
+        // DMA Channel 2: restarts the DMA channel 1
+        dma_channel_config cfg = dma_channel_get_default_config(s_channel_2); // default configs
+        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);			  // 32-bit txfers
+        channel_config_set_read_increment(&cfg, true);						  // next head each time
+        channel_config_set_ring(&cfg, false, 3);							  // 8 byte boundary on read ptr
+        channel_config_set_write_increment(&cfg, false);					  // no write incrementing
+        channel_config_set_irq_quiet(&cfg, true);
+
+        dma_channel_configure(s_channel_2,								   // Channel to be configured
+                              &cfg,										   // The configuration we just created
+                              &dma_hw->ch[s_channel_1].al3_read_addr_trig, // Write address (channel 1 read address)
+                              s_list_head,								   // Read address (POINTER TO AN ADDRESS)
+                              1,										   // Number of transfers, in this case each is 4 byte
+                              false										   // Don't start immediately.
+        );
+    }
+
+    // End of frame irq, only the last block of a list raises it.
+    dma_channel_set_irq0_enabled(s_channel_0, true);
+    irq_set_exclusive_handler(DMA_IRQ_0, dma_irq_handler);
+    irq_set_enabled(DMA_IRQ_0, true);
+}
+
+void display_list_set_frame_callback(void (*callback)(void))
+{
+    s_frame_callback = callback;
+}
+
+void display_list_begin(struct display_list_t* list, struct control_block_t* blocks, uint capacity)
+{
+    list->blocks = blocks;
+    list->capacity = capacity;
+    list->count = 0;
+}
+
+static bool add_block(struct display_list_t* list, uint32_t ctrl, const void* read_addr, uint32_t count)
+{
+    if (list->count == list->capacity)
+    {
+        return false;
+    }
+
+    hard_assert(((uintptr_t)read_addr & 3) == 0);
+    list->blocks[list->count++] = (struct control_block_t){ctrl, read_addr, s_write_addr, count};
+    return true;
+}
+
+bool display_list_add_words(struct display_list_t* list, const void* words, uint count)
+{
+    // Words right after the previous ones in memory just make the previous block longer.
+    if (list->count > 0)
+    {
+        struct control_block_t* last = &list->blocks[list->count - 1];
+        if (last->ctrl == s_ctrl_pixels && (const uint8_t*)last->read_addr + last->count * 4 == words)
+        {
+            last->count += count;
+            return true;
+        }
+    }
+
+    return add_block(list, s_ctrl_pixels, words, count);
+}
+
+bool display_list_add_fill(struct display_list_t* list, const uint32_t* word, uint count)
+{
+    if (list->count > 0)
+    {
+        struct control_block_t* last = &list->blocks[list->count - 1];
+        if (last->ctrl == s_ctrl_border && last->read_addr == word)
+        {
+            last->count += count;
+            return true;
+        }
+    }
+
+    return add_block(list, s_ctrl_border, word, count);
+}
+
+bool display_list_add_lines(struct display_list_t* list, const uint8_t* pixels, uint lines)
+{
+    return display_list_add_words(list, pixels, lines * s_line_words);
+}
+
+bool display_list_add_line(struct display_list_t* list, const uint8_t* pixels)
+{
+    return add_block(list, s_ctrl_pixels, pixels, s_line_words);
+}
+
+bool display_list_add_border(struct display_list_t* list, const uint32_t* color, uint lines)
+{
+    return display_list_add_fill(list, color, lines * s_line_words);
+}
+
+void display_list_end(struct display_list_t* list)
+{
+    hard_assert(list->count > 0);
+
+    struct control_block_t* last = &list->blocks[list->count - 1];
+    last->ctrl = (last->ctrl == s_ctrl_border) ? s_ctrl_border_end : s_ctrl_pixels_end;
+}
+
+void display_list_show(const struct display_list_t* list)
+{
+    display_list_show_fields(list, list);
+}
+
+void display_list_show_fields(const struct display_list_t* first, const struct display_list_t* second)
+{
+    s_list_head[0] = first->blocks;
+    s_list_head[1] = second->blocks;
+}
+
+bool display_list_is_active(const struct display_list_t* list)
+{
+    // After copying a block channel 1 halts pointing right after it, so the end of the list is included.
+    const uintptr_t read_addr = dma_hw->ch[s_channel_1].read_addr;
+    return read_addr >= (uintptr_t)list->blocks && read_addr <= (uintptr_t)(list->blocks + list->count);
+}
+
+int display_list_get_block(const struct display_list_t* list)
+{
+    // Channel 1 halts pointing right after the block it copied into channel 0.
+    const struct control_block_t* next = (const struct control_block_t*)(uintptr_t)dma_hw->ch[s_channel_1].read_addr;
+    return (int)(next - list->blocks) - 1;
+}
+
+void display_list_start(void)
+{
+    // Channel 2 loads the head of the list shown into channel 1 and triggers it.
+    dma_channel_set_read_addr(s_channel_2, s_list_head, false);
+    dma_start_channel_mask(1u << s_channel_2);
+}
+
+void display_list_stop(void)
+{
+    // An aborted channel may still raise its irq, that's no end of frame.
+    dma_channel_set_irq0_enabled(s_channel_0, false);
+    dma_channel_abort(s_channel_0);
+    dma_channel_abort(s_channel_1);
+    dma_channel_abort(s_channel_2);
+    dma_hw->ints0 = 1u << s_channel_0;
+    dma_channel_set_irq0_enabled(s_channel_0, true);
+}
@@ -0,0 +1,83 @@
+/**
+ * DMA display list.
+ *
+ * A display list is an array of DMA control blocks, one per scanline or per run of
+ * scanlines, that channel 1 copies into channel 0 one by one. Each block points at the
+ * pixels for its lines, so lines can be repeated, reordered or taken from different
+ * buffers without copying a single byte. Consecutive lines that are contiguous in memory
+ * are merged into one block. Channel 0 moves 32-bit words, 8 pixels per bus transfer, so
+ * lines must be 4 byte aligned and a multiple of 4 bytes long.
+ *
+ * The last block chains to channel 2, which restarts channel 1 at the head of the list
+ * selected with display_list_show(), and raises DMA_IRQ_0 (the end of frame callback).
+ * Channel 2 alternates between two heads, one per field, so interlaced sends a different
+ * list in each field (display_list_show_fields()); progressive just sets both the same.
+ */
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+
+#include "hardware/pio.h"
+#include "pico/stdlib.h"
+
+struct control_block_t
+{
+    uint32_t ctrl;					// Must maps to al1_ctrl
+    const volatile void* read_addr; // Must maps to al1_read_addr
+    io_wo_32* write_addr;			// Must maps to al1_write_addr
+    uint32_t count;					// Must maps to al1_transfer_count_trig, in words
+};
+
+struct display_list_t
+{
+    struct control_block_t* blocks; // Storage provided by the owner of the list.
+    uint capacity;
+    uint count;
+};
+
+// Claim the three DMA channels that feed the tx fifo of the given state machine, line_bytes (a multiple of 4) per scanline.
+void display_list_init(PIO pio, uint sm, uint line_bytes);
+
+// Called from DMA_IRQ_0 each time a list (a field) finishes, right after channel 2 restarted channel 1.
+void display_list_set_frame_callback(void (*callback)(void));
+
+// Start building a list into the given storage.
+void display_list_begin(struct display_list_t* list, struct control_block_t* blocks, uint capacity);
+
+// Append count words read from words, merged into the previous block if they follow it in memory. Returns false
+// if the list is full.
+bool display_list_add_words(struct display_list_t* list, const void* words, uint count);
+
+// Append the same word count times, merged into the previous block if it sends the same one.
+bool display_list_add_fill(struct display_list_t* list, const uint32_t* word, uint count);
+
+// Append lines read from pixels, line_bytes each. Returns false if the list is full.
+bool display_list_add_lines(struct display_list_t* list, const uint8_t* pixels, uint lines);
+
+// Append a single line with its own block, even if it follows the previous one in memory.
+bool display_list_add_line(struct display_list_t* list, const uint8_t* pixels);
+
+// Append lines of a single color, the same word (4 identical bytes) is sent over and over.
+bool display_list_add_border(struct display_list_t* list, const uint32_t* color, uint lines);
+
+// Close the list, the last block restarts the list shown and raises the end of frame irq.
+void display_list_end(struct display_list_t* list);
+
+// Make the list the one channel 2 restarts from in every field, it takes effect at the next field.
+void display_list_show(const struct display_list_t* list);
+
+// Lists of the first and the second field of interlaced, each takes effect at the next time its field starts.
+void display_list_show_fields(const struct display_list_t* first, const struct display_list_t* second);
+
+// True while channel 1 is walking the given list.
+bool display_list_is_active(const struct display_list_t* list);
+
+// Index of the block channel 0 is sending while the list is active.
+int display_list_get_block(const struct display_list_t* list);
+
+// Start sending the list shown, from the one of the first field.
+void display_list_start(void);
+
+// Abort the three channels, with the state machine already stopped.
+void display_list_stop(void);
+
+#endif
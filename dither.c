@@ -0,0 +1,110 @@
+/**
+ * Dithering of 24-bit pictures, see dither.h.
+ */
+#include "dither.h"
+
+#include <stdbool.h>
+
+#define LEVELS ((1u << VIDEO_COLOR_BITS) - 1)
+
+// Thresholds 0 to 15, every 2x2 block of them spread as far apart as possible.
+static const uint8_t s_bayer[4][4] = {{0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+
+// Level of a channel value at each of 32 thresholds: 2 * t + phase for the threshold t of the matrix.
+static uint8_t s_levels[32][256];
+static bool s_levels_ready = false;
+
+static void build_levels(void)
+{
+    for (unsigned t = 0; t < 32; t++)
+    {
+        for (unsigned v = 0; v < 256; v++)
+        {
+            // v scaled to 0..LEVELS plus a threshold of (t + 0.5) / 32, rounded down.
+            s_levels[t][v] = (v * LEVELS * 64 + (2 * t + 1) * 255) / (255 * 64);
+        }
+    }
+    s_levels_ready = true;
+}
+
+// Pin code of the pixel at r, g, b with the levels of its threshold.
+static inline unsigned pixel(const uint8_t* levels, const uint8_t* rgb)
+{
+    return levels[rgb[0]] | (levels[rgb[1]] << VIDEO_COLOR_BITS) | (levels[rgb[2]] << (2 * VIDEO_COLOR_BITS));
+}
+
+void dither_line(uint8_t* line, const uint8_t* rgb, unsigned width, unsigned y, unsigned phase)
+{
+    if (!s_levels_ready)
+    {
+        build_levels();
+    }
+
+    // Levels of the 4 columns of the row, every threshold half a step up in phase 1.
+    const uint8_t* levels[4];
+    for (unsigned i = 0; i < 4; i++)
+    {
+        levels[i] = s_levels[2 * s_bayer[y & 3][i] + (phase & 1)];
+    }
+
+    unsigned x = 0;
+#if VIDEO_COLOR_BITS > 1
+    uint16_t* out = (uint16_t*)line;
+    for (; x + 4 <= width; x += 4, rgb += 12)
+    {
+        out[x] = pixel(levels[0], rgb);
+        out[x + 1] = pixel(levels[1], rgb + 3);
+        out[x + 2] = pixel(levels[2], rgb + 6);
+        out[x + 3] = pixel(levels[3], rgb + 9);
+    }
+    for (; x < width; x++, rgb += 3)
+    {
+        out[x] = pixel(levels[x & 3], rgb);
+    }
+#elif VIDEO_DENSE_PIXELS
+    uint32_t* out = (uint32_t*)line;
+    for (; x + 10 <= width; x += 10)
+    {
+        uint32_t word = 0;
+        for (unsigned i = 0; i < 10; i++, rgb += 3)
+        {
+            word |= (uint32_t)pixel(levels[(x + i) & 3], rgb) << (i * 3);
+        }
+        *out++ = word;
+    }
+    if (x < width)
+    {
+        uint32_t word = 0;
+        uint32_t mask = 0;
+        for (unsigned i = 0; x + i < width; i++, rgb += 3)
+        {
+            word |= (uint32_t)pixel(levels[(x + i) & 3], rgb) << (i * 3);
+            mask |= 7u << (i * 3);
+        }
+        *out = (*out & ~mask) | word;
+    }
+#else
+    for (; x + 4 <= width; x += 4, rgb += 12)
+    {
+        *line++ = pixel(levels[0], rgb) | (pixel(levels[1], rgb + 3) << 3);
+        *line++ = pixel(levels[2], rgb + 6) | (pixel(levels[3], rgb + 9) << 3);
+    }
+    for (; x + 2 <= width; x += 2, rgb += 6)
+    {
+        *line++ = pixel(levels[x & 3], rgb) | (pixel(levels[(x + 1) & 3], rgb + 3) << 3);
+    }
+    if (x < width)
+    {
+        *line = (*line & 0x38) | pixel(levels[x & 3], rgb);
+    }
+#endif
+}
+
+void dither_image(uint8_t* pixels, unsigned stride, const uint8_t* rgb, unsigned rgb_stride, unsigned width, unsigned height,
+                  unsigned phase)
+{
+    for (unsigned y = 0; y < height; y++)
+    {
+        dither_line(pixels + y * stride, rgb + y * rgb_stride, width, y, phase);
+    }
+}
@@ -0,0 +1,35 @@
+/**
+ * Dithering of 24-bit pictures into the framebuffer format.
+ *
+ * Ordered dithering with a 4x4 Bayer matrix: each channel of each pixel is rounded up or down
+ * to the VIDEO_COLOR_BITS levels by comparing it with the threshold of its place in the
+ * matrix, so 8 colours look like 17 shades of each channel from a distance. Per channel it is
+ * a lookup in a table of the levels at each threshold (8 KB in RAM, built on the first call),
+ * no error to carry from one pixel to the next, so a line takes a few microseconds and any
+ * line can be converted on its own.
+ *
+ * Temporal dithering on top: phase 1 moves every threshold up by half a step, in between the
+ * ones of phase 0, so a picture converted once with phase 0 and once with phase 1 into the two
+ * framebuffers, shown in alternate fields (a flip every field), averages 33 shades per channel
+ * at 25 Hz of flicker (tools/dither_bench counts them).
+ *
+ * Plain C without the SDK so tools/dither_bench measures the very same code on the host.
+ */
+#ifndef DITHER_H
+#define DITHER_H
+
+#include "pixel_format.h"
+
+#include <stdint.h>
+
+#define DITHER_PHASES 2
+
+// Convert width pixels of r, g, b bytes into a line of the framebuffer format (see pixel_format.h),
+// y picks the row of the matrix. An odd pixel left over in the last byte / word keeps its neighbours.
+void dither_line(uint8_t* line, const uint8_t* rgb, unsigned width, unsigned y, unsigned phase);
+
+// Convert a whole picture, rows stride bytes apart in the framebuffer and rgb_stride bytes apart in the source.
+void dither_image(uint8_t* pixels, unsigned stride, const uint8_t* rgb, unsigned rgb_stride, unsigned width, unsigned height,
+                  unsigned phase);
+
+#endif
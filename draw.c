@@ -0,0 +1,385 @@
+/**
+ * Drawing into packed pixel buffers, see draw.h.
+ */
+#include "draw.h"
+
+#include <string.h>
+
+// The SDK puts the spans in RAM, the host build runs them from wherever.
+#if __has_include("pico/platform.h")
+#include "pico/platform.h"
+#else
+#define __not_in_flash_func(name) name
+#endif
+#ifndef MIN
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#endif
+
+#define EVEN_MASK 0x07
+#define ODD_MASK 0x38
+
+// A word of pixels of the same color.
+static inline uint32_t color_pattern(uint16_t color)
+{
+    return VIDEO_COLOR_WORD(color);
+}
+
+// Clip the rectangle to the surface, false if nothing is left.
+static bool clip(const struct surface_t* surface, int* x, int* y, int* width, int* height)
+{
+    if (*x < 0)
+    {
+        *width += *x;
+        *x = 0;
+    }
+    if (*y < 0)
+    {
+        *height += *y;
+        *y = 0;
+    }
+    *width = MIN(*width, surface->width - *x);
+    *height = MIN(*height, surface->height - *y);
+    return *width > 0 && *height > 0;
+}
+
+#if VIDEO_COLOR_BITS > 1
+
+// Pixels [x0, x1) of a row of halfwords, x0 < x1: pairs of pixels written as words.
+static void __not_in_flash_func(fill_span)(uint8_t* row, unsigned x0, unsigned x1, uint32_t pattern)
+{
+    uint16_t* pixels = (uint16_t*)row;
+    if (x0 & 1)
+    {
+        pixels[x0++] = pattern;
+    }
+    if (x1 & 1)
+    {
+        pixels[--x1] = pattern;
+    }
+
+    uint32_t* p = (uint32_t*)(pixels + x0);
+    uint32_t* const end = (uint32_t*)(pixels + x1);
+    while (p < end)
+    {
+        *p++ = pattern;
+    }
+}
+
+#elif VIDEO_DENSE_PIXELS
+
+// Bits of the pixels [first, last) of a word, first < last <= 10.
+static inline uint32_t pixel_mask(unsigned first, unsigned last)
+{
+    return ((1u << (last * 3)) - 1) & ~((1u << (first * 3)) - 1);
+}
+
+// Pixels [x0, x1) of a row, x0 < x1: the first and last words are merged in, the ones in between written.
+static void __not_in_flash_func(fill_span)(uint8_t* row, unsigned x0, unsigned x1, uint32_t pattern)
+{
+    uint32_t* p = (uint32_t*)row + x0 / 10;
+    uint32_t* const last = (uint32_t*)row + (x1 - 1) / 10;
+    const unsigned first = x0 % 10;
+    const unsigned end = x1 - (x1 - 1) / 10 * 10;
+
+    if (p == last)
+    {
+        const uint32_t mask = pixel_mask(first, end);
+        *p = (*p & ~mask) | (pattern & mask);
+        return;
+    }
+
+    const uint32_t first_mask = pixel_mask(first, 10);
+    *p = (*p & ~first_mask) | (pattern & first_mask);
+    p++;
+    while (p < last)
+    {
+        *p++ = pattern;
+    }
+    const uint32_t last_mask = pixel_mask(0, end);
+    *p = (*p & ~last_mask) | (pattern & last_mask);
+}
+
+#else
+
+// Pixels [x0, x1) of a row, x0 < x1.
+static void __not_in_flash_func(fill_span)(uint8_t* row, unsigned x0, unsigned x1, uint32_t pattern)
+{
+    // Odd first pixel / even last pixel share their byte with a pixel outside the span.
+    if (x0 & 1)
+    {
+        row[x0 >> 1] = (row[x0 >> 1] & EVEN_MASK) | (pattern & ODD_MASK);
+        x0++;
+    }
+    if (x1 & 1)
+    {
+        row[x1 >> 1] = (row[x1 >> 1] & ODD_MASK) | (pattern & EVEN_MASK);
+        x1--;
+    }
+
+    uint8_t* p = row + (x0 >> 1);
+    uint8_t* const end = row + (x1 >> 1);
+    while (p < end && ((uintptr_t)p & 3))
+    {
+        *p++ = pattern;
+    }
+    while (p + 4 <= end)
+    {
+        *(uint32_t*)p = pattern;
+        p += 4;
+    }
+    while (p < end)
+    {
+        *p++ = pattern;
+    }
+}
+
+#endif
+
+void draw_clear(const struct surface_t* surface, uint16_t color)
+{
+#if VIDEO_COLOR_BITS > 1 || VIDEO_DENSE_PIXELS
+    draw_fill_rect(surface, 0, 0, surface->width, surface->height, color);
+#else
+    // An odd last pixel shares its byte with one outside the surface.
+    const uint8_t pattern = color | (color << 3);
+    const unsigned row_bytes = surface->width >> 1;
+    for (int y = 0; y < surface->height; y++)
+    {
+        uint8_t* row = surface->pixels + y * surface->stride;
+        memset(row, pattern, row_bytes);
+        if (surface->width & 1)
+        {
+            row[row_bytes] = (row[row_bytes] & ODD_MASK) | (pattern & EVEN_MASK);
+        }
+    }
+#endif
+}
+
+void draw_fill_rect(const struct surface_t* surface, int x, int y, int width, int height, uint16_t color)
+{
+    if (!clip(surface, &x, &y, &width, &height))
+    {
+        return;
+    }
+
+    const uint32_t pattern = color_pattern(color);
+    uint8_t* row = surface->pixels + y * surface->stride;
+    for (int i = 0; i < height; i++, row += surface->stride)
+    {
+        fill_span(row, x, x + width, pattern);
+    }
+}
+
+void draw_hline(const struct surface_t* surface, int x, int y, int width, uint16_t color)
+{
+    draw_fill_rect(surface, x, y, width, 1, color);
+}
+
+void draw_vline(const struct surface_t* surface, int x, int y, int height, uint16_t color)
+{
+    int width = 1;
+    if (!clip(surface, &x, &y, &width, &height))
+    {
+        return;
+    }
+
+    // The stride in a local, the stores could change *surface.
+    const unsigned stride = surface->stride;
+#if VIDEO_COLOR_BITS > 1
+    // A halfword on every row.
+    uint8_t* p = surface->pixels + y * stride + x * 2;
+    for (int i = 0; i < height; i++, p += stride)
+    {
+        *(uint16_t*)p = color;
+    }
+#elif VIDEO_DENSE_PIXELS
+    // Same pixel of the same word on every row.
+    const uint32_t mask = 7u << ((x % 10) * 3);
+    const uint32_t value = color_pattern(color) & mask;
+    uint8_t* p = surface->pixels + y * stride + x / 10 * 4;
+    for (int i = 0; i < height; i++, p += stride)
+    {
+        *(uint32_t*)p = (*(uint32_t*)p & ~mask) | value;
+    }
+#else
+    // Same half of the same byte on every row.
+    const uint8_t keep = (x & 1) ? EVEN_MASK : ODD_MASK;
+    const uint8_t value = color_pattern(color) & ~keep;
+    uint8_t* p = surface->pixels + y * stride + (x >> 1);
+    for (int i = 0; i < height; i++, p += stride)
+    {
+        *p = (*p & keep) | value;
+    }
+#endif
+}
+
+#if VIDEO_COLOR_BITS > 1
+
+static void __not_in_flash_func(copy_span)(uint8_t* dst, const uint8_t* src, unsigned x, unsigned src_x, unsigned width)
+{
+    memcpy(dst + x * 2, src + src_x * 2, width * 2);
+}
+
+#elif VIDEO_DENSE_PIXELS
+
+static inline unsigned get_pixel(const uint8_t* row, unsigned x)
+{
+    return (((const uint32_t*)row)[x / 10] >> ((x % 10) * 3)) & 7;
+}
+
+static inline void set_pixel(uint8_t* row, unsigned x, unsigned color)
+{
+    uint32_t* word = (uint32_t*)row + x / 10;
+    const unsigned shift = (x % 10) * 3;
+    *word = (*word & ~(7u << shift)) | (color << shift);
+}
+
+static void __not_in_flash_func(copy_span)(uint8_t* dst, const uint8_t* src, unsigned x, unsigned src_x, unsigned width)
+{
+    if (x % 10 != src_x % 10)
+    {
+        // Every pixel moves within its word, one by one.
+        for (unsigned i = 0; i < width; i++)
+        {
+            set_pixel(dst, x + i, get_pixel(src, src_x + i));
+        }
+        return;
+    }
+
+    // Same place in the word: whole words copy as they are, the first and last ones merged in.
+    uint32_t* d = (uint32_t*)dst + x / 10;
+    const uint32_t* s = (const uint32_t*)src + src_x / 10;
+    unsigned first = x % 10;
+    unsigned left = first + width;
+    while (left > 0)
+    {
+        const unsigned last = MIN(left, 10);
+        const uint32_t mask = pixel_mask(first, last);
+        *d = (*d & ~mask) | (*s & mask);
+        d++;
+        s++;
+        left -= last;
+        first = 0;
+    }
+}
+
+#else
+
+static inline unsigned get_pixel(const uint8_t* row, unsigned x)
+{
+    return (row[x >> 1] >> ((x & 1) * 3)) & 7;
+}
+
+static inline void set_pixel(uint8_t* row, unsigned x, unsigned color)
+{
+    const unsigned shift = (x & 1) * 3;
+    row[x >> 1] = (row[x >> 1] & ~(7 << shift)) | (color << shift);
+}
+
+// Source and destination start on the same half of a byte: whole bytes copy as they are.
+static void __not_in_flash_func(copy_span_aligned)(uint8_t* dst, const uint8_t* src, unsigned x, unsigned src_x, unsigned width)
+{
+    if (x & 1)
+    {
+        set_pixel(dst, x++, get_pixel(src, src_x++));
+        width--;
+    }
+    if (width & 1)
+    {
+        width--;
+        set_pixel(dst, x + width, get_pixel(src, src_x + width));
+    }
+
+    memcpy(dst + (x >> 1), src + (src_x >> 1), width >> 1);
+}
+
+// Each destination byte takes the odd pixel of a source byte and the even pixel of the next one.
+static inline uint32_t shift_pixels(uint32_t current, uint32_t next)
+{
+    return ((current >> 3) & 0x07070707u) | ((next & 0x07070707u) << 3);
+}
+
+static void __not_in_flash_func(copy_span_shifted)(uint8_t* dst, const uint8_t* src, unsigned x, unsigned src_x, unsigned width)
+{
+    if (x & 1)
+    {
+        set_pixel(dst, x++, get_pixel(src, src_x++));
+        width--;
+    }
+    if (width & 1)
+    {
+        width--;
+        set_pixel(dst, x + width, get_pixel(src, src_x + width));
+    }
+
+    // Now x is even and src_x odd.
+    uint8_t* p = dst + (x >> 1);
+    uint8_t* const end = p + (width >> 1);
+    const uint8_t* s = src + (src_x >> 1);
+    while (p < end && ((uintptr_t)p & 3))
+    {
+        *p++ = shift_pixels(s[0], s[1]);
+        s++;
+    }
+    while (p + 4 <= end)
+    {
+        // 8 pixels at once, the source can be at any alignment.
+        const uint32_t current = s[0] | (s[1] << 8) | (s[2] << 16) | ((uint32_t)s[3] << 24);
+        const uint32_t next = (current >> 8) | ((uint32_t)s[4] << 24);
+        *(uint32_t*)p = shift_pixels(current, next);
+        p += 4;
+        s += 4;
+    }
+    while (p < end)
+    {
+        *p++ = shift_pixels(s[0], s[1]);
+        s++;
+    }
+}
+
+static void __not_in_flash_func(copy_span)(uint8_t* dst, const uint8_t* src, unsigned x, unsigned src_x, unsigned width)
+{
+    if (((x ^ src_x) & 1) == 0)
+    {
+        copy_span_aligned(dst, src, x, src_x, width);
+    }
+    else
+    {
+        copy_span_shifted(dst, src, x, src_x, width);
+    }
+}
+
+#endif
+
+void draw_blit(const struct surface_t* surface, int x, int y, const struct surface_t* source, int src_x, int src_y, int width, int height)
+{
+    // Clip against the source first, then against the destination, moving both origins.
+    int clipped_x = src_x;
+    int clipped_y = src_y;
+    if (!clip(source, &clipped_x, &clipped_y, &width, &height))
+    {
+        return;
+    }
+    x += clipped_x - src_x;
+    y += clipped_y - src_y;
+    src_x = clipped_x;
+    src_y = clipped_y;
+
+    clipped_x = x;
+    clipped_y = y;
+    if (!clip(surface, &clipped_x, &clipped_y, &width, &height))
+    {
+        return;
+    }
+    src_x += clipped_x - x;
+    src_y += clipped_y - y;
+    x = clipped_x;
+    y = clipped_y;
+
+    uint8_t* dst = surface->pixels + y * surface->stride;
+    const uint8_t* src = source->pixels + src_y * source->stride;
+    for (int i = 0; i < height; i++, dst += surface->stride, src += source->stride)
+    {
+        copy_span(dst, src, x, src_x, width);
+    }
+}
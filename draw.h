@@ -0,0 +1,48 @@
+/**
+ * Drawing into packed pixel buffers (2 pixels per byte, even pixel in bits 0-2, odd pixel
+ * in bits 3-5, the framebuffer format).
+ *
+ * Spans are written 32 bits (8 pixels) at a time, an odd first or last pixel is merged in
+ * with a mask, so there is no per pixel branch or read-modify-write. Everything is clipped
+ * to the surface.
+ *
+ * With VIDEO_DENSE_PIXELS the buffers are 10 pixels per 32-bit word instead (see video.h),
+ * rows 4 byte aligned: spans merge the first and last words, a blit between different
+ * places in the word goes pixel by pixel. With VIDEO_COLOR_BITS above 1 a pixel is a
+ * halfword, the colours are VIDEO_RGB() codes.
+ *
+ * Plain C without the SDK so tools/draw_bench measures the very same code on the host.
+ */
+#ifndef DRAW_H
+#define DRAW_H
+
+#include "pixel_format.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Bytes of a row of width pixels, a whole number of words with VIDEO_DENSE_PIXELS or multi-bit colour.
+#define DRAW_ROW_BYTES(width)                                                                                                          \
+    (VIDEO_COLOR_BITS > 1 ? ((width) + 1) / 2 * 4 : VIDEO_DENSE_PIXELS ? ((width) + 9) / 10 * 4 : ((width) + 1) / 2)
+
+struct surface_t
+{
+    uint8_t* pixels;
+    int width;
+    int height;
+    unsigned stride; // bytes from one row to the next.
+};
+
+// Fill the whole surface.
+void draw_clear(const struct surface_t* surface, uint16_t color);
+
+void draw_fill_rect(const struct surface_t* surface, int x, int y, int width, int height, uint16_t color);
+void draw_hline(const struct surface_t* surface, int x, int y, int width, uint16_t color);
+// Not one of the spans: a pixel per row merged into its byte (word), no faster than setting the pixels one by one,
+// only clipped once.
+void draw_vline(const struct surface_t* surface, int x, int y, int height, uint16_t color);
+
+// Copy a width x height block from (src_x, src_y) of source to (x, y) of surface.
+void draw_blit(const struct surface_t* surface, int x, int y, const struct surface_t* source, int src_x, int src_y, int width, int height);
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * Double or triple buffered framebuffer mode, see framebuffer.h.
+ */
+#include "framebuffer.h"
+
+static uint8_t s_framebuffer[FRAMEBUFFER_COUNT][FRAMEBUFFER_SIZE] __attribute__((aligned(4)));
+
+// One display list per framebuffer and field: top border, real pixels (from the scroll row to the end of
+// the ring and from the start of the ring up to the last visible line) and bottom border. Interlaced
+// lines are two rows apart and repeated rows go back one, so then each line has a block of its own, at
+// the same place whatever the scroll: a scroll only changes where they read.
+#define FRAMEBUFFER_LINE_BLOCKS (VIDEO_INTERLACED || VIDEO_LINE_REPEAT > 1)
+#define FRAMEBUFFER_BLOCKS (FRAMEBUFFER_LINE_BLOCKS ? RES_Y + 2 : 4)
+static struct control_block_t s_blocks[FRAMEBUFFER_COUNT][VIDEO_FIELDS][FRAMEBUFFER_BLOCKS];
+static struct display_list_t s_lists[FRAMEBUFFER_COUNT][VIDEO_FIELDS];
+static uint s_line_block; // Block of the first line, after the top border.
+
+// Index of the framebuffer the DMA reads, of the one to show next while a flip is pending and of the
+// one to draw into. Double buffered the back buffer is the front one while a flip is pending.
+static volatile uint s_front = 0;
+static volatile uint s_next = 0;
+static uint s_back = 1;
+static volatile bool s_flip_pending = false;
+
+// Ring row shown on the first visible line, the one asked for until the next field, and the one each list was
+// built with.
+static volatile uint s_scroll = 0;
+static volatile uint s_scroll_next = 0;
+static volatile bool s_scroll_pending = false;
+static uint s_list_scroll[FRAMEBUFFER_COUNT][VIDEO_FIELDS];
+
+static void build_display_list(uint index, uint field)
+{
+    struct display_list_t* list = &s_lists[index][field];
+    display_list_begin(list, s_blocks[index][field], FRAMEBUFFER_BLOCKS);
+    video_add_border_top(list);
+    s_line_block = list->count;
+    for (uint y = 0; y < RES_Y;)
+    {
+        const uint row = (y * VIDEO_FIELDS + field) / VIDEO_LINE_REPEAT;
+        const uint8_t* pixels = framebuffer_get_line(s_framebuffer[index], row);
+        if (FRAMEBUFFER_LINE_BLOCKS)
+        {
+            display_list_add_line(list, pixels);
+            y++;
+        }
+        else
+        {
+            // The rows run to the end of the ring, one call for all of them keeps the list at 4 blocks.
+            const uint lines = MIN(RES_Y - y, FRAMEBUFFER_LINES - (s_scroll + row) % FRAMEBUFFER_LINES);
+            display_list_add_lines(list, pixels, lines);
+            y += lines;
+        }
+    }
+    video_add_border_bottom(list, field);
+    display_list_end(list);
+    s_list_scroll[index][field] = s_scroll;
+}
+
+// Point the blocks of the lines at the rows of the scroll, the rest of the list stays as it is. The ring wraps once
+// at most, a subtraction instead of a division per line.
+static void scroll_display_list(uint index, uint field)
+{
+    struct control_block_t* blocks = &s_blocks[index][field][s_line_block];
+    const uint first = s_scroll * LINE_COUNT;
+    for (uint y = 0; y < RES_Y; y++)
+    {
+        uint offset = first + (y * VIDEO_FIELDS + field) / VIDEO_LINE_REPEAT * LINE_COUNT;
+        if (offset >= FRAMEBUFFER_SIZE)
+        {
+            offset -= FRAMEBUFFER_SIZE;
+        }
+        blocks[y].read_addr = s_framebuffer[index] + offset;
+    }
+    s_list_scroll[index][field] = s_scroll;
+}
+
+static void build_display_lists(uint index)
+{
+    for (uint field = 0; field < VIDEO_FIELDS; field++)
+    {
+        build_display_list(index, field);
+    }
+}
+
+static void show(uint index)
+{
+    display_list_show_fields(&s_lists[index][0], &s_lists[index][VIDEO_FIELDS - 1]);
+}
+
+static bool is_active(uint index)
+{
+    for (uint field = 0; field < VIDEO_FIELDS; field++)
+    {
+        if (display_list_is_active(&s_lists[index][field]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs right after channel 2 restarted channel 1, so if it's already walking the list of the next
+// buffer the old front buffer has been sent completely and the swap is done.
+static void frame_handler(void)
+{
+    if (s_flip_pending && is_active(s_next))
+    {
+        s_front = s_next;
+        s_flip_pending = false;
+    }
+
+    if (s_scroll_pending)
+    {
+        s_scroll_pending = false;
+        s_scroll = s_scroll_next;
+    }
+
+    // Channel 1 is sending the top border of the front list, its pixel blocks won't be read for a good while:
+    // bring it to the scroll if it isn't. The other lists catch up when their turn comes.
+    for (uint field = 0; field < VIDEO_FIELDS; field++)
+    {
+        if (s_list_scroll[s_front][field] != s_scroll && display_list_is_active(&s_lists[s_front][field]))
+        {
+            if (FRAMEBUFFER_LINE_BLOCKS)
+            {
+                scroll_display_list(s_front, field);
+            }
+            else
+            {
+                build_display_list(s_front, field);
+            }
+        }
+    }
+}
+
+static void build_all(void)
+{
+    for (uint index = 0; index < FRAMEBUFFER_COUNT; index++)
+    {
+        build_display_lists(index);
+    }
+    show(s_flip_pending ? s_next : s_front);
+}
+
+void framebuffer_init(void)
+{
+    build_all();
+    display_list_set_frame_callback(frame_handler);
+    video_set_list_builder(build_all);
+}
+
+uint8_t* framebuffer_get_back(void)
+{
+    return s_framebuffer[s_back];
+}
+
+uint8_t* framebuffer_get_front(void)
+{
+    return s_framebuffer[s_front];
+}
+
+void framebuffer_flip(void)
+{
+    framebuffer_wait_flip();
+    s_next = s_back;
+    // The one buffer that is neither shown nor next, or the front one.
+    s_back = FRAMEBUFFER_COUNT == 3 ? 3 - s_front - s_next : s_front;
+    s_flip_pending = true;
+    show(s_next);
+}
+
+bool framebuffer_flip_pending(void)
+{
+    return s_flip_pending;
+}
+
+void framebuffer_wait_flip(void)
+{
+    while (s_flip_pending)
+    {
+        tight_loop_contents();
+    }
+}
+
+void framebuffer_set_scroll(uint row)
+{
+    s_scroll_next = row % FRAMEBUFFER_LINES;
+    s_scroll_pending = true;
+}
+
+bool framebuffer_scroll_pending(void)
+{
+    return s_scroll_pending;
+}
+
+uint8_t* framebuffer_get_line(uint8_t* framebuffer, uint y)
+{
+    return framebuffer + ((s_scroll + y) % FRAMEBUFFER_LINES) * LINE_COUNT;
+}
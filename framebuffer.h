@@ -0,0 +1,66 @@
+/**
+ * Double or triple buffered framebuffer mode.
+ *
+ * The application draws into the back buffer and asks for a flip, the flip is applied
+ * once the beam is in the bottom border / vsync so the picture never tears. Double
+ * buffered the back buffer is the one shown until then, triple buffered (FRAMEBUFFER_COUNT 3)
+ * a third one is free to draw the next picture into right away.
+ *
+ * Each framebuffer is a ring of FRAMEBUFFER_LINES rows, one more than the visible ones.
+ * Vertical scroll picks which row is shown on the first line, the display list reads the
+ * rows from there and wraps around, so scrolling never moves pixels: draw the row coming
+ * into view in the spare row and scroll by one.
+ *
+ * Interlaced (VIDEO_INTERLACED), the ring holds a whole frame of FRAME_Y rows and each field
+ * has its own display list with every other line of it.
+ *
+ * With VIDEO_LINE_REPEAT 2 the buffers are half as many rows and the display lists send each
+ * row on two lines, a block per line.
+ */
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include "video.h"
+
+// Framebuffers, 2 or 3.
+#ifndef FRAMEBUFFER_COUNT
+#define FRAMEBUFFER_COUNT 2
+#endif
+#if FRAMEBUFFER_COUNT != 2 && FRAMEBUFFER_COUNT != 3
+#error "FRAMEBUFFER_COUNT must be 2 or 3"
+#endif
+
+#define FRAMEBUFFER_LINES (FRAME_Y + 1) // 1 spare row to draw the one scrolling in.
+#define FRAMEBUFFER_SIZE (LINE_COUNT * FRAMEBUFFER_LINES)
+
+// Build the display lists of all framebuffers and show the front one, call between video_init() and video_start().
+// video_set_mode() builds them again.
+void framebuffer_init(void);
+
+// Framebuffer not being scanned out, safe to draw into while no flip is pending (at any time triple buffered).
+uint8_t* framebuffer_get_back(void);
+
+// Framebuffer being scanned out.
+uint8_t* framebuffer_get_front(void);
+
+// Show the back buffer from the next vertical blank. A flip still pending is waited for first. Triple buffered
+// the back buffer is the third one from now on, double buffered the front one once the flip is applied.
+void framebuffer_flip(void);
+
+// True from framebuffer_flip() until the swap has been applied.
+bool framebuffer_flip_pending(void);
+
+// Block until the requested flip has been applied, after that the back buffer can be drawn again.
+void framebuffer_wait_flip(void);
+
+// Show ring row `row` on the first visible line (of all framebuffers), applied at the next vertical blank.
+void framebuffer_set_scroll(uint row);
+
+// True from framebuffer_set_scroll() until the new scroll has been applied.
+bool framebuffer_scroll_pending(void);
+
+// Address of row y of the picture (0 to FRAME_Y - 1) with the scroll shown, a new one counts once
+// framebuffer_scroll_pending() is false.
+uint8_t* framebuffer_get_line(uint8_t* framebuffer, uint y);
+
+#endif
@@ -0,0 +1,264 @@
+/**
+ * 8-bit indexed colour, see indexed.h.
+ */
+#include "indexed.h"
+
+#include "hardware/interp.h"
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+#include <string.h>
+
+static uint8_t s_pixels[RES_Y][RES_X] __attribute__((aligned(4)));
+
+#if VIDEO_COLOR_BITS > 1
+// The pixel of each index.
+static uint16_t s_codes[INDEXED_COLORS];
+#else
+// Pin codes of each index for an even and for an odd pixel.
+static uint8_t s_even[INDEXED_COLORS];
+static uint8_t s_odd[INDEXED_COLORS];
+#endif
+
+struct line_change_t
+{
+    uint8_t index;
+    uint16_t color;
+};
+
+// Core 0 writes a change and then counts it, core 1 only reads.
+static struct line_change_t s_line_changes[RES_Y][INDEXED_LINE_CHANGES];
+static volatile uint8_t s_line_change_count[RES_Y];
+
+// Cycles measured on core 1 with its SysTick.
+static uint32_t s_worst_render_cycles = 0;
+static uint32_t s_change_cycles = 0;
+
+static const uint16_t s_default_colors[8] = {BLACK, RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN, WHITE};
+
+// The interpolators and the SysTick are per core, set up on the first line core 1 renders.
+static bool s_interp_ready = false;
+
+void indexed_init(void)
+{
+    memset(s_pixels, 0, sizeof(s_pixels));
+    indexed_clear_line_colors();
+    for (uint i = 0; i < INDEXED_COLORS; i++)
+    {
+        indexed_set_color(i, s_default_colors[i % 8]);
+    }
+}
+
+uint8_t* indexed_get_pixels(void)
+{
+    return &s_pixels[0][0];
+}
+
+void indexed_set_color(uint8_t index, uint16_t color)
+{
+#if VIDEO_COLOR_BITS > 1
+    s_codes[index] = color;
+#else
+    s_even[index] = color & 7;
+    s_odd[index] = (color & 7) << 3;
+#endif
+}
+
+void indexed_set_palette(uint first, const uint16_t* colors, uint count)
+{
+    for (uint i = 0; i < count && first + i < INDEXED_COLORS; i++)
+    {
+        indexed_set_color(first + i, colors[i]);
+    }
+}
+
+uint16_t indexed_get_color(uint8_t index)
+{
+#if VIDEO_COLOR_BITS > 1
+    return s_codes[index];
+#else
+    return s_even[index];
+#endif
+}
+
+bool indexed_add_line_color(uint y, uint8_t index, uint16_t color)
+{
+    const uint count = s_line_change_count[y];
+    if (count == INDEXED_LINE_CHANGES)
+    {
+        return false;
+    }
+
+    s_line_changes[y][count] = (struct line_change_t){index, color};
+    __dmb();
+    s_line_change_count[y] = count + 1;
+    return true;
+}
+
+void indexed_clear_line_colors(void)
+{
+    memset((void*)s_line_change_count, 0, sizeof(s_line_change_count));
+}
+
+void indexed_get_budget(struct indexed_budget_t* budget)
+{
+    const struct video_mode_t* mode = video_get_mode();
+    budget->line_cycles = (uint64_t)video_get_clock_plan()->sys_hz * 1000 / mode->line_mhz;
+    budget->worst_render_cycles = s_worst_render_cycles;
+    budget->change_cycles = s_change_cycles;
+    budget->changes_per_line = 0;
+    if (s_change_cycles > 0 && budget->line_cycles > s_worst_render_cycles)
+    {
+        budget->changes_per_line = (budget->line_cycles - s_worst_render_cycles) / s_change_cycles;
+    }
+}
+
+// The 24-bit SysTick of the core counts the system clock down.
+static inline uint32_t cycles_since(uint32_t start)
+{
+    return (start - systick_hw->cvr) & 0xffffff;
+}
+
+// Counting cycles and the cost of a palette change, on core 1.
+static void setup_timing(void)
+{
+    systick_hw->rvr = 0xffffff;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // Enabled, system clock.
+
+    // Entries set to what they have, a load and a store like a line change.
+    const uint32_t start = systick_hw->cvr;
+    for (uint i = 0; i < 16; i++)
+    {
+        indexed_set_color(i, indexed_get_color(i));
+    }
+    s_change_cycles = (cycles_since(start) + 15) / 16;
+}
+
+static inline void apply_line_changes(uint y)
+{
+    const uint count = s_line_change_count[y];
+    __dmb();
+    for (uint i = 0; i < count; i++)
+    {
+        indexed_set_color(s_line_changes[y][i].index, s_line_changes[y][i].color);
+    }
+}
+
+// Keep the slowest lookup of a line.
+static inline void end_line(uint32_t start)
+{
+    const uint32_t cycles = cycles_since(start);
+    if (cycles > s_worst_render_cycles)
+    {
+        s_worst_render_cycles = cycles;
+    }
+}
+
+#if VIDEO_COLOR_BITS > 1
+
+// The accumulator has the indices one bit up (times 2, halfword offsets): lane 0 adds the byte at
+// bits 1-8 to the table, lane 1 the one at bits 9-16, both from accumulator 0.
+static void setup_interp(interp_hw_t* interp)
+{
+    interp_config cfg = interp_default_config();
+    interp_config_set_mask(&cfg, 1, 8);
+    interp_set_config(interp, 0, &cfg);
+
+    interp_config_set_shift(&cfg, 8);
+    interp_config_set_cross_input(&cfg, true);
+    interp_set_config(interp, 1, &cfg);
+
+    interp->base[0] = (uintptr_t)s_codes;
+    interp->base[1] = (uintptr_t)s_codes;
+}
+
+// A word of the line, the 2 pixels the interpolator has.
+static inline uint32_t lookup_pair(interp_hw_t* interp)
+{
+    return *(const uint16_t*)(uintptr_t)interp->peek[0] | (*(const uint16_t*)(uintptr_t)interp->peek[1] << 16);
+}
+
+void __not_in_flash_func(indexed_render_line)(uint y, uint8_t* line)
+{
+    if (!s_interp_ready)
+    {
+        setup_interp(interp0);
+        setup_interp(interp1);
+        setup_timing();
+        s_interp_ready = true;
+    }
+    apply_line_changes(y);
+    const uint32_t start = systick_hw->cvr;
+
+    const uint32_t* in = (const uint32_t*)s_pixels[y];
+    uint32_t* out = (uint32_t*)line;
+
+    // 4 pixels, a word of indices, per 2 words of the line.
+    for (uint x = 0; x < RES_X / 4; x++)
+    {
+        interp0->accum[0] = in[x] << 1;
+        interp1->accum[0] = in[x] >> 15;
+        out[0] = lookup_pair(interp0);
+        out[1] = lookup_pair(interp1);
+        out += 2;
+    }
+    end_line(start);
+}
+
+#else
+
+// Lane 0 adds the byte at shift to the even table, lane 1 the next one to the odd table, both from accumulator 0.
+static void setup_interp(interp_hw_t* interp, uint shift)
+{
+    interp_config cfg = interp_default_config();
+    interp_config_set_shift(&cfg, shift);
+    interp_config_set_mask(&cfg, 0, 7);
+    interp_set_config(interp, 0, &cfg);
+
+    interp_config_set_shift(&cfg, shift + 8);
+    interp_config_set_cross_input(&cfg, true);
+    interp_set_config(interp, 1, &cfg);
+
+    interp->base[0] = (uintptr_t)s_even;
+    interp->base[1] = (uintptr_t)s_odd;
+}
+
+// Two bytes of the line from the 2 pixels the interpolator has.
+static inline uint32_t lookup_pair(interp_hw_t* interp)
+{
+    return *(const uint8_t*)(uintptr_t)interp->peek[0] | *(const uint8_t*)(uintptr_t)interp->peek[1];
+}
+
+void __not_in_flash_func(indexed_render_line)(uint y, uint8_t* line)
+{
+    if (!s_interp_ready)
+    {
+        setup_interp(interp0, 0);
+        setup_interp(interp1, 16);
+        setup_timing();
+        s_interp_ready = true;
+    }
+    apply_line_changes(y);
+    const uint32_t start = systick_hw->cvr;
+
+    const uint32_t* in = (const uint32_t*)s_pixels[y];
+    uint32_t* out = (uint32_t*)line;
+
+    // 8 pixels, 2 words of indices, per word of the line.
+    for (uint x = 0; x < LINE_COUNT / 4; x++)
+    {
+        interp0->accum[0] = in[0];
+        interp1->accum[0] = in[0];
+        uint32_t word = lookup_pair(interp0) | (lookup_pair(interp1) << 8);
+
+        interp0->accum[0] = in[1];
+        interp1->accum[0] = in[1];
+        word |= (lookup_pair(interp0) << 16) | (lookup_pair(interp1) << 24);
+
+        out[x] = word;
+        in += 2;
+    }
+    end_line(start);
+}
+
+#endif
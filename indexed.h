@@ -0,0 +1,64 @@
+/**
+ * 8-bit indexed colour for the scanline mode.
+ *
+ * The picture is RES_Y rows of RES_X palette indices, a byte per pixel, and
+ * indexed_render_line() is a scanline_render_t that turns a row into pin codes through a 256
+ * entry palette as core 1 renders it. A palette change shows from the next line on, so
+ * palette cycling and fades are a few writes instead of a redraw.
+ *
+ * The lookup runs on the interpolators of core 1: a word of 4 indices goes into both
+ * accumulators and the lanes give the palette addresses of the 4 pixels (interp0 pixels 0
+ * and 1, interp1 pixels 2 and 3). The palette is kept as the code of an even pixel (bits 0-2)
+ * and of an odd one (bits 3-5), so a byte of the line is the or of two loads. With
+ * VIDEO_COLOR_BITS above 1 it is the 16-bit pixel of each index, the way to get the most of
+ * a DAC out of a third of the memory of a 16-bit picture.
+ *
+ * Palette changes can also be tied to a line: core 1 makes them right before it renders the
+ * line, every frame, so raster bars and gradients through a palette entry land exactly on
+ * their line. indexed_get_budget() tells how many of them a line has time for.
+ */
+#ifndef INDEXED_H
+#define INDEXED_H
+
+#include "video.h"
+
+#define INDEXED_COLORS 256
+
+// Palette changes a single line can hold.
+#ifndef INDEXED_LINE_CHANGES
+#define INDEXED_LINE_CHANGES 8
+#endif
+
+// Time core 1 has and takes for a line, in system clock cycles.
+struct indexed_budget_t
+{
+    uint32_t line_cycles;		  // A line of the mode, core 1 has to render one line per line.
+    uint32_t worst_render_cycles; // The slowest lookup of a line so far, without its palette changes.
+    uint32_t change_cycles;		  // A palette change.
+    uint changes_per_line;		  // Palette changes that fit in a line on top of the slowest lookup.
+};
+
+// Clear the picture and set the default palette, index i is colour i % 8 (BLACK to WHITE).
+void indexed_init(void);
+
+// RES_Y rows of RES_X indices, 4 byte aligned. Can be written at any time.
+uint8_t* indexed_get_pixels(void);
+
+// Colour (a pin code, BLACK to WHITE or VIDEO_RGB()) of one palette entry / of count entries from first.
+void indexed_set_color(uint8_t index, uint16_t color);
+void indexed_set_palette(uint first, const uint16_t* colors, uint count);
+uint16_t indexed_get_color(uint8_t index);
+
+// Set palette entry index to color right before visible line y is rendered, from the next frame on. The colour
+// stays until something changes it again. Returns false if the line has INDEXED_LINE_CHANGES already.
+bool indexed_add_line_color(uint y, uint8_t index, uint16_t color);
+
+// Remove the changes of every line.
+void indexed_clear_line_colors(void);
+
+void indexed_get_budget(struct indexed_budget_t* budget);
+
+// scanline_render_t: look up the indices of visible line y.
+void indexed_render_line(uint y, uint8_t* line);
+
+#endif
@@ -0,0 +1,51 @@
+/**
+ * Pixel format and colours, set at build time.
+ *
+ * Plain C without the SDK so the host tools use the very same format.
+ */
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+// Bits per colour channel. 1: a pin per channel through a resistor, 8 colours. 2-5: a resistor ladder DAC
+// per channel (3-3-3, 4-4-4, 5-5-5 ...), 3 * VIDEO_COLOR_BITS consecutive pins from RED_PIN, red in the
+// lowest ones, and pixels of 16 bits, 2 per 32-bit word (150 KB for a 320x240 picture).
+#ifndef VIDEO_COLOR_BITS
+#define VIDEO_COLOR_BITS 1
+#endif
+#if VIDEO_COLOR_BITS < 1 || VIDEO_COLOR_BITS > 5
+#error "VIDEO_COLOR_BITS is 1 to 5, the 3 channels of a pixel fit in 16 bits"
+#endif
+#define VIDEO_RGB_PINS (3 * VIDEO_COLOR_BITS)
+
+// Pixel format of 1 bit colour, 3 bits per pixel. 0: 2 pixels per byte, bits 0-2 and 3-5 (8 per 32-bit word).
+// 1: 10 pixels per 32-bit word, pixel i in bits 3i to 3i+2, bits 30-31 unused: a fifth smaller framebuffers,
+// only the framebuffer mode and draw.h know it (the scanline renderers work on bytes).
+#ifndef VIDEO_DENSE_PIXELS
+#define VIDEO_DENSE_PIXELS 0
+#endif
+#if VIDEO_COLOR_BITS > 1 && VIDEO_DENSE_PIXELS
+#error "VIDEO_DENSE_PIXELS is a format of 1 bit colour"
+#endif
+
+#define VIDEO_PIXELS_PER_WORD (VIDEO_COLOR_BITS > 1 ? 2 : VIDEO_DENSE_PIXELS ? 10 : 8)
+
+// A 32-bit word of pixels all of the same color.
+#define VIDEO_COLOR_WORD(color)                                                                                                    \
+    (VIDEO_COLOR_BITS > 1 ? (color) * 0x00010001u : VIDEO_DENSE_PIXELS ? (color) * 0x09249249u : ((color) | ((color) << 3)) * 0x01010101u)
+
+// Pin code of a colour of 8-bit components, the top VIDEO_COLOR_BITS of each.
+#define VIDEO_RGB(r, g, b)                                                                                                             \
+    (((r) >> (8 - VIDEO_COLOR_BITS)) | (((g) >> (8 - VIDEO_COLOR_BITS)) << VIDEO_COLOR_BITS) |                                        \
+     (((b) >> (8 - VIDEO_COLOR_BITS)) << (2 * VIDEO_COLOR_BITS)))
+
+// The 8 colours of 1 bit per channel (0 to 7), full scale with a DAC.
+#define BLACK VIDEO_RGB(0, 0, 0)
+#define RED VIDEO_RGB(255, 0, 0)
+#define GREEN VIDEO_RGB(0, 255, 0)
+#define YELLOW VIDEO_RGB(255, 255, 0)
+#define BLUE VIDEO_RGB(0, 0, 255)
+#define MAGENTA VIDEO_RGB(255, 0, 255)
+#define CYAN VIDEO_RGB(0, 255, 255)
+#define WHITE VIDEO_RGB(255, 255, 255)
+
+#endif
@@ -0,0 +1,169 @@
+/**
+ * Raster mode, see raster.h.
+ */
+#include "raster.h"
+
+#include <string.h>
+
+static struct raster_line_t s_tables[2][RES_Y];
+static uint16_t s_borders[2][RASTER_BORDER_LINES];
+
+// Words the colour lines of each table send, the picture lines then the border lines, consecutive lines of the
+// same colour share one.
+static uint32_t s_colors[2][RES_Y + RASTER_BORDER_LINES];
+
+// With the scroll program of video_set_hscroll() a line is its scroll word and the pixels, one more word of them.
+static bool s_fine = false;
+static uint32_t s_scroll_words[VIDEO_PIXELS_PER_WORD];
+
+static struct control_block_t s_blocks[2][RASTER_BLOCKS];
+static struct display_list_t s_lists[2];
+
+// Index of the table shown, the other one is the back table. The frame handler only switches the index, the
+// back table is brought up to date by raster_get_back() on core 0.
+static volatile uint s_front = 0;
+static volatile bool s_commit_pending = false;
+static bool s_back_copied = true;
+
+// A line of a single colour, its word in *word. The same word as the line above merges into its block, *last is
+// the word of the line above if it was a colour line too.
+static bool add_color_line(struct display_list_t* list, uint16_t color, uint32_t* word, const uint32_t** last)
+{
+    const uint32_t value = s_fine ? video_get_color_line_word(color) : VIDEO_COLOR_WORD(color);
+    if (!*last || **last != value)
+    {
+        *word = value;
+        *last = word;
+    }
+    return s_fine ? display_list_add_fill(list, *last, 1) : display_list_add_border(list, *last, 1);
+}
+
+static void build_display_list(uint index)
+{
+    const struct raster_line_t* lines = s_tables[index];
+    const uint16_t* borders = s_borders[index];
+    uint32_t* colors = s_colors[index];
+    struct display_list_t* list = &s_lists[index];
+
+    // The lines with irq 0 of the field: the top border, the picture and what is left below it.
+    const struct video_mode_t* mode = video_get_mode();
+    const uint top = mode->border_top_lines;
+    const uint border_lines = mode->fields[0][0].lines - RES_Y;
+    hard_assert(border_lines <= RASTER_BORDER_LINES);
+
+    display_list_begin(list, s_blocks[index], RASTER_BLOCKS);
+    bool fits = true;
+    const uint32_t* color = NULL;
+    for (uint i = 0; i < top; i++)
+    {
+        fits &= add_color_line(list, borders[i], &colors[RES_Y + i], &color);
+    }
+    for (uint y = 0; y < RES_Y; y++)
+    {
+        const struct raster_line_t* line = &lines[y];
+        if (!line->pixels)
+        {
+            fits &= add_color_line(list, line->color, &colors[y], &color);
+            continue;
+        }
+
+        const uint8_t* pixels = line->pixels + line->offset / VIDEO_PIXELS_PER_WORD * 4;
+        if (s_fine)
+        {
+            fits &= display_list_add_words(list, &s_scroll_words[line->offset % VIDEO_PIXELS_PER_WORD], 1);
+            fits &= display_list_add_words(list, pixels, LINE_COUNT / 4 + 1);
+        }
+        else
+        {
+            fits &= display_list_add_lines(list, pixels, 1);
+        }
+        color = NULL;
+    }
+    for (uint i = top; i < border_lines; i++)
+    {
+        fits &= add_color_line(list, borders[i], &colors[RES_Y + i], &color);
+    }
+    hard_assert(fits);
+    display_list_end(list);
+}
+
+// Runs right after channel 2 restarted channel 1, walking the new list means the old one is done with.
+static void frame_handler(void)
+{
+    if (s_commit_pending && display_list_is_active(&s_lists[s_front ^ 1]))
+    {
+        s_front ^= 1;
+        s_commit_pending = false;
+    }
+}
+
+static void build_all(void)
+{
+    build_display_list(0);
+    build_display_list(1);
+    display_list_show(&s_lists[s_front]);
+}
+
+void raster_init(void)
+{
+    hard_assert(!VIDEO_INTERLACED);
+    s_fine = video_set_hscroll(true);
+    for (uint pixels = 0; s_fine && pixels < VIDEO_PIXELS_PER_WORD; pixels++)
+    {
+        s_scroll_words[pixels] = video_get_scroll_word(pixels);
+    }
+    for (uint y = 0; y < RES_Y; y++)
+    {
+        s_tables[0][y] = s_tables[1][y] = (struct raster_line_t){NULL, 0, BLACK};
+    }
+    for (uint i = 0; i < RASTER_BORDER_LINES; i++)
+    {
+        s_borders[0][i] = s_borders[1][i] = BLACK;
+    }
+
+    build_all();
+    display_list_set_frame_callback(frame_handler);
+    video_set_list_builder(build_all);
+}
+
+struct raster_line_t* raster_get_back(void)
+{
+    raster_wait_commit();
+    const uint back = s_front ^ 1;
+    if (!s_back_copied)
+    {
+        memcpy(s_tables[back], s_tables[back ^ 1], sizeof(s_tables[0]));
+        memcpy(s_borders[back], s_borders[back ^ 1], sizeof(s_borders[0]));
+        s_back_copied = true;
+    }
+    return s_tables[back];
+}
+
+uint16_t* raster_get_back_border(void)
+{
+    raster_get_back();
+    return s_borders[s_front ^ 1];
+}
+
+void raster_commit(void)
+{
+    raster_wait_commit();
+    const uint back = s_front ^ 1;
+    s_back_copied = false;
+    build_display_list(back);
+    s_commit_pending = true;
+    display_list_show(&s_lists[back]);
+}
+
+bool raster_commit_pending(void)
+{
+    return s_commit_pending;
+}
+
+void raster_wait_commit(void)
+{
+    while (s_commit_pending)
+    {
+        tight_loop_contents();
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * Raster mode: a table says what each visible line shows.
+ *
+ * A line takes its pixels from any row of any buffer, some pixels in, or is a single colour:
+ * the display list has a block per line pointing at it, so split screens (a HUD over a
+ * playfield), rows repeated, horizontal scroll of a wider buffer and gradient or banded
+ * backgrounds cost nothing while the picture is sent and no pixel is ever redrawn.
+ *
+ * Scrolling is by single pixels: the whole words of the offset move the DMA read address and
+ * the rest is dropped by the scroll program of the rgb state machine (video_set_hscroll()),
+ * which gets a word in front of each line saying how many, so a line is two blocks. With
+ * VIDEO_DENSE_PIXELS there is no scroll program: offsets go by whole words (10 pixels, the
+ * rest is ignored) and rows that follow each other in memory merge into one block, like in
+ * the framebuffer mode.
+ *
+ * The border lines above and below the picture have an entry too, a colour each, so raster
+ * bars and gradients run on into the borders. video_set_border_color() has no effect here.
+ *
+ * The application edits the back table and commits it, the display list of it is shown from
+ * the next field and the back table starts again as a copy of it. The frame handler only
+ * switches which table is shown, the copy is made by the next raster_get_back().
+ *
+ * A line entry has no palette: the DMA sends the pixels as they are in memory, there is no
+ * lookup to change in the middle of the picture. Palette changes at a line are part of the
+ * indexed mode, where core 1 looks the pixels up (indexed_add_line_color(), see indexed.h).
+ * Progressive only.
+ */
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "video.h"
+
+// Border lines of the longest field of any mode: PAL, 42 above the picture and 22 below.
+#define RASTER_BORDER_LINES 64
+
+// Budget: a line is a block of the display list, two with the scroll program, a border line one at most, of 16
+// bytes that channel 1 loads into channel 0 in the horizontal blanking. The DMA keeps up whatever the table holds
+// and the picture takes no CPU time while it is sent. raster_commit() builds the list on core 0, some tens of
+// cycles per block: RASTER_BLOCKS at most, well under a millisecond at 125 MHz. A list that doesn't fit asserts.
+#define RASTER_BLOCKS (2 * RES_Y + RASTER_BORDER_LINES)
+
+struct raster_line_t
+{
+    const uint8_t* pixels; // Row shown on the line (4 byte aligned), NULL for a line of color.
+    uint16_t offset;	   // Pixels of the row skipped, LINE_COUNT + 4 bytes must follow the word it is in.
+    uint16_t color;		   // Colour of the whole line when pixels is NULL.
+};
+
+// Both tables all BLACK lines and border lines. Load the scroll program, build the display list and show it, call between
+// video_init() and video_start().
+// video_set_mode() builds it again.
+void raster_init(void);
+
+// RES_Y lines to edit, a copy of the table shown. Waits for a pending commit, call it again after each commit.
+struct raster_line_t* raster_get_back(void);
+
+// Colours of the border lines of the back table, from the top of the field: the border_top_lines of the mode above
+// the picture, then the lines below it, up to RASTER_BORDER_LINES (the rest of them unused). Waits like
+// raster_get_back(), committed with the table.
+uint16_t* raster_get_back_border(void);
+
+// Show the back table from the next field, waits for a pending commit first.
+void raster_commit(void);
+
+// True from raster_commit() until the new table is shown.
+bool raster_commit_pending(void);
+
+// Block until the committed table is shown, after that the back table can be edited again.
+void raster_wait_commit(void);
+
+#endif
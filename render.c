@@ -0,0 +1,155 @@
+/**
+ * Render queue on core 1, see render.h.
+ */
+#include "render.h"
+
+#include "framebuffer.h"
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+
+static struct render_command_t s_queue[RENDER_QUEUE_DEPTH];
+
+// Free running counts, the slot is the count modulo the depth. Only core 0 writes the head
+// and only core 1 the tail.
+static volatile uint32_t s_head = 0;
+static volatile uint32_t s_tail = 0;
+
+// Core 0 only.
+static uint s_max_occupancy = 0;
+static uint32_t s_rejected = 0;
+
+static void run(const struct render_command_t* command)
+{
+    const struct surface_t back = {framebuffer_get_back(), RES_X, FRAME_Y, LINE_COUNT};
+
+    switch (command->type)
+    {
+    case RENDER_CLEAR:
+        draw_clear(&back, command->color);
+        break;
+    case RENDER_FILL_RECT:
+        draw_fill_rect(&back, command->x, command->y, command->width, command->height, command->color);
+        break;
+    case RENDER_HLINE:
+        draw_hline(&back, command->x, command->y, command->width, command->color);
+        break;
+    case RENDER_VLINE:
+        draw_vline(&back, command->x, command->y, command->height, command->color);
+        break;
+    case RENDER_BLIT:
+        draw_blit(&back, command->x, command->y, command->source, command->src_x, command->src_y, command->width, command->height);
+        break;
+    case RENDER_FLIP:
+        // Triple buffered the back buffer is free right away.
+        framebuffer_flip();
+        if (FRAMEBUFFER_COUNT == 2)
+        {
+            framebuffer_wait_flip();
+        }
+        break;
+    }
+}
+
+static void core1_main(void)
+{
+    while (true)
+    {
+        // Sleep on the doorbell while the ring is empty, the head was moved before it rang.
+        while (s_tail == s_head)
+        {
+            multicore_fifo_pop_blocking();
+        }
+
+        __dmb();
+        run(&s_queue[s_tail % RENDER_QUEUE_DEPTH]);
+        __dmb();
+        s_tail = s_tail + 1;
+    }
+}
+
+void render_init(void)
+{
+    multicore_launch_core1(core1_main);
+}
+
+bool render_push(const struct render_command_t* command)
+{
+    const uint32_t head = s_head;
+    if (head - s_tail == RENDER_QUEUE_DEPTH)
+    {
+        s_rejected++;
+        return false;
+    }
+
+    s_queue[head % RENDER_QUEUE_DEPTH] = *command;
+    __dmb();
+    s_head = head + 1;
+
+    const uint occupancy = head + 1 - s_tail;
+    s_max_occupancy = MAX(s_max_occupancy, occupancy);
+
+    // If the FIFO is full core 1 has doorbells to go through already.
+    if (multicore_fifo_wready())
+    {
+        multicore_fifo_push_blocking(0);
+    }
+    return true;
+}
+
+bool render_clear(uint16_t color)
+{
+    return render_push(&(struct render_command_t){.type = RENDER_CLEAR, .color = color});
+}
+
+bool render_fill_rect(int x, int y, int width, int height, uint16_t color)
+{
+    return render_push(&(struct render_command_t){.type = RENDER_FILL_RECT, .color = color, .x = x, .y = y, .width = width, .height = height});
+}
+
+bool render_hline(int x, int y, int width, uint16_t color)
+{
+    return render_push(&(struct render_command_t){.type = RENDER_HLINE, .color = color, .x = x, .y = y, .width = width});
+}
+
+bool render_vline(int x, int y, int height, uint16_t color)
+{
+    return render_push(&(struct render_command_t){.type = RENDER_VLINE, .color = color, .x = x, .y = y, .height = height});
+}
+
+bool render_blit(int x, int y, const struct surface_t* source, int src_x, int src_y, int width, int height)
+{
+    return render_push(&(struct render_command_t){
+        .type = RENDER_BLIT, .x = x, .y = y, .width = width, .height = height, .source = source, .src_x = src_x, .src_y = src_y});
+}
+
+bool render_flip(void)
+{
+    return render_push(&(struct render_command_t){.type = RENDER_FLIP});
+}
+
+bool render_is_idle(void)
+{
+    return s_tail == s_head;
+}
+
+void render_wait_idle(void)
+{
+    while (!render_is_idle())
+    {
+        tight_loop_contents();
+    }
+}
+
+void render_get_stats(struct render_stats_t* stats)
+{
+    const uint32_t head = s_head;
+    const uint32_t tail = s_tail;
+    *stats = (struct render_stats_t){
+        .depth = RENDER_QUEUE_DEPTH,
+        .occupancy = head - tail,
+        .max_occupancy = s_max_occupancy,
+        .pushed = head,
+        .completed = tail,
+        .rejected = s_rejected,
+    };
+}
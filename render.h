@@ -0,0 +1,86 @@
+/**
+ * Render queue: core 1 draws into the framebuffers, core 0 only queues commands.
+ *
+ * Commands go into a ring in shared memory with a single producer (core 0) and a single
+ * consumer (core 1): core 0 writes the command and then moves the head, core 1 runs it and
+ * then moves the tail, so neither side takes a lock or disables interrupts. The multicore
+ * FIFO is just the doorbell: core 1 sleeps in it while the ring is empty and core 0 rings it
+ * after each push, without waiting if the FIFO is full (core 1 is awake then anyway).
+ *
+ * Commands draw into the back buffer of the framebuffer mode with draw.h, in order.
+ * render_flip() queues the flip: core 1 asks for it and waits for the vertical blank, the
+ * commands after it draw into the new back buffer. Triple buffered (FRAMEBUFFER_COUNT 3) it
+ * only waits for the flip before, if that one is still pending. A full ring never blocks core 0, the push
+ * fails and is counted, so size RENDER_QUEUE_DEPTH for the commands of a frame or two.
+ *
+ * Core 1 is the render core, don't use it with the scanline mode.
+ */
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "draw.h"
+#include "pico/stdlib.h"
+
+// Commands the ring holds, a power of 2.
+#ifndef RENDER_QUEUE_DEPTH
+#define RENDER_QUEUE_DEPTH 128
+#endif
+#if RENDER_QUEUE_DEPTH & (RENDER_QUEUE_DEPTH - 1)
+#error "RENDER_QUEUE_DEPTH must be a power of 2"
+#endif
+
+#define RENDER_CLEAR 0
+#define RENDER_FILL_RECT 1
+#define RENDER_HLINE 2
+#define RENDER_VLINE 3
+#define RENDER_BLIT 4
+#define RENDER_FLIP 5
+
+struct render_command_t
+{
+    uint8_t type;
+    uint16_t color;
+    int16_t x;
+    int16_t y;
+    int16_t width;
+    int16_t height;
+    // RENDER_BLIT: what to copy from, it has to stay as it is until the command has run.
+    const struct surface_t* source;
+    int16_t src_x;
+    int16_t src_y;
+};
+
+struct render_stats_t
+{
+    uint depth;			  // RENDER_QUEUE_DEPTH.
+    uint occupancy;		  // Commands waiting or running right now.
+    uint max_occupancy;	  // Most commands waiting at once since render_init().
+    uint32_t pushed;	  // Commands queued.
+    uint32_t completed;	  // Commands run.
+    uint32_t rejected;	  // Pushes that found the ring full.
+};
+
+// Start the render loop on core 1, after framebuffer_init().
+void render_init(void);
+
+// Queue a command, false if the ring is full (the command is dropped). Core 0 only.
+bool render_push(const struct render_command_t* command);
+
+bool render_clear(uint16_t color);
+bool render_fill_rect(int x, int y, int width, int height, uint16_t color);
+bool render_hline(int x, int y, int width, uint16_t color);
+bool render_vline(int x, int y, int height, uint16_t color);
+bool render_blit(int x, int y, const struct surface_t* source, int src_x, int src_y, int width, int height);
+
+// Show what was drawn so far at the next vertical blank.
+bool render_flip(void);
+
+// True once core 1 has run every command queued.
+bool render_is_idle(void);
+
+// Block until core 1 has run every command queued, e.g. before touching a blit source again.
+void render_wait_idle(void);
+
+void render_get_stats(struct render_stats_t* stats);
+
+#endif
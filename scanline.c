@@ -0,0 +1,102 @@
+/**
+ * Scanline (race the beam) mode, see scanline.h.
+ */
+#include "scanline.h"
+
+#include "hardware/irq.h"
+#include "pico/multicore.h"
+
+static uint8_t s_lines[SCANLINE_BUFFERS][LINE_COUNT] __attribute__((aligned(4)));
+
+// Top border, one block per visible line and bottom border.
+static struct control_block_t s_blocks[RES_Y + 2];
+static struct display_list_t s_list;
+
+static scanline_render_t s_render;
+
+// Next line to render, RES_Y once the frame is done.
+static int s_next_line = RES_Y;
+static volatile uint32_t s_missed_lines = 0;
+
+// Visible line the DMA is sending: -1 in the top border, RES_Y or more in the bottom border.
+static inline int get_beam_line(void)
+{
+    return display_list_get_block(&s_list) - 1;
+}
+
+// The rgb state machine clears irq 0 right away, but the pulse is enough to leave the interrupt pending.
+static void __not_in_flash_func(line_irq_handler)(void)
+{
+    const int beam = get_beam_line();
+
+    if (beam < 0)
+    {
+        // Top border: start a new frame.
+        if (s_next_line >= RES_Y)
+        {
+            s_next_line = 0;
+        }
+    }
+    else if (s_next_line <= beam && s_next_line < RES_Y)
+    {
+        // The DMA got there first, skip those lines.
+        const int next_line = MIN(beam + 1, RES_Y);
+        s_missed_lines += next_line - s_next_line;
+        s_next_line = next_line;
+    }
+
+    // The buffer of the beam line is being read, all the others are free.
+    const int last_line = MIN(beam + SCANLINE_BUFFERS - 1, RES_Y - 1);
+    while (s_next_line <= last_line)
+    {
+        const int y = s_next_line++;
+        s_render(y, s_lines[y % SCANLINE_BUFFERS]);
+
+        if (get_beam_line() >= y)
+        {
+            s_missed_lines++;
+        }
+    }
+}
+
+static void core1_main(void)
+{
+    pio_set_irq0_source_enabled(VIDEO_PIO, pis_interrupt0, true);
+    irq_set_exclusive_handler(PIO0_IRQ_0, line_irq_handler);
+    irq_set_enabled(PIO0_IRQ_0, true);
+
+    while (true)
+    {
+        __wfi();
+    }
+}
+
+static void build_display_list(void)
+{
+    display_list_begin(&s_list, s_blocks, count_of(s_blocks));
+    video_add_border_top(&s_list);
+    for (uint y = 0; y < RES_Y; y++)
+    {
+        display_list_add_line(&s_list, s_lines[y % SCANLINE_BUFFERS]);
+    }
+    video_add_border_bottom(&s_list, 0);
+    display_list_end(&s_list);
+    display_list_show(&s_list);
+}
+
+void scanline_init(scanline_render_t render)
+{
+    hard_assert(!VIDEO_INTERLACED);
+    hard_assert(!VIDEO_DENSE_PIXELS); // The renderers write bytes of 2 pixels or halfwords.
+    s_render = render;
+
+    build_display_list();
+    video_set_list_builder(build_display_list);
+
+    multicore_launch_core1(core1_main);
+}
+
+uint32_t scanline_get_missed_lines(void)
+{
+    return s_missed_lines;
+}
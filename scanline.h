@@ -0,0 +1,27 @@
+/**
+ * Scanline (race the beam) mode.
+ *
+ * There is no framebuffer: the display list sends each visible line from a small ring of
+ * SCANLINE_BUFFERS line buffers, and core 1 calls the render function to fill a line a few
+ * lines ahead of the beam. Core 1 is woken up by the irq 0 the csync state machine raises at
+ * the start of every line, and any line that wasn't ready when the DMA got to it is counted.
+ */
+#ifndef SCANLINE_H
+#define SCANLINE_H
+
+#include "video.h"
+
+#define SCANLINE_BUFFERS 4
+
+// Fill `line` (LINE_COUNT bytes, 2 pixels per byte or a halfword per pixel with VIDEO_COLOR_BITS above 1, 4 byte
+// aligned) with the pixels of visible line y.
+typedef void (*scanline_render_t)(uint y, uint8_t* line);
+
+// Build the display list, show it and start the render loop on core 1. Call between video_init() and video_start().
+// Progressive only, a single list with the bottom border of field 0. video_set_mode() builds it again.
+void scanline_init(scanline_render_t render);
+
+// Lines whose render deadline was missed since start, they show whatever the buffer had.
+uint32_t scanline_get_missed_lines(void);
+
+#endif
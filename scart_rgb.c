@@ -8,193 +8,513 @@
  *  - GPIO 20 ---> 330 ohm resistor ---> VGA Blue
  *
  */
-#include "hardware/dma.h"
-#include "hardware/pio.h"
 #include "pico/stdlib.h"
 #include <stdio.h>
 
-#include "csync.pio.h"
-#include "rgb.pio.h"
+#include "dither.h"
+#include "draw.h"
+#include "framebuffer.h"
+#include "indexed.h"
+#include "raster.h"
+#include "render.h"
+#include "scanline.h"
+#include "sprites.h"
+#include "tilemap.h"
+#include "video.h"
+
+// Which demo to run.
+#define DEMO_FRAMEBUFFER 0 // scroll color bars in a framebuffer.
+#define DEMO_SCANLINE 1	   // render the bars line by line on core 1.
+#define DEMO_TILEMAP 2	   // tile map on core 1.
+#define DEMO_SPRITES 3	   // bouncing sprites over the tile map.
+#define DEMO_DRAW 4		   // double buffered rectangles drawn every frame.
+#define DEMO_INDEXED 5	   // palette cycling over an 8-bit indexed picture, raster bars of line palette changes.
+#define DEMO_DITHER 6	   // 24-bit gradients dithered, both phases shown in turn.
+#define DEMO_RENDER 7	   // the draw demo through the render queue, drawn on core 1.
+#define DEMO_RASTER 8	   // split screen from a table of lines: HUD, scrolling playfield, moving bands.
+#define DEMO DEMO_FRAMEBUFFER
+
+// video_mode_ntsc for 60 Hz monitors, see video.h for the others.
+#define MODE video_mode_pal
+
+static const uint16_t s_colors[8] = {BLACK, RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN, WHITE};
+
+// One line of vertical color bars of 40 pixels, starting with the given color.
+static void draw_color_bars(uint8_t* line, uint color_index)
+{
+    const struct surface_t surface = {line, RES_X, 1, LINE_COUNT};
+    for (int x = 0; x < RES_X; x += 40)
+    {
+        draw_hline(&surface, x, 0, 40, s_colors[color_index]);
+        color_index = (color_index + 1) % 8;
+    }
+}
+
+static volatile uint s_frame = 0;
+
+// Scanline mode: same bars scrolling up, computed for each line as the beam gets there.
+static void render_color_bars(uint y, uint8_t* line)
+{
+    draw_color_bars(line, ((y + s_frame) / 30) % 8);
+}
+
+static void scanline_demo(void)
+{
+    scanline_init(render_color_bars);
+    video_start();
 
-#define SCAN_LINES 304
-#define BORDER_TOP_LINES 42
-#define BORDER_BOTTOM_LINES 22
+    uint32_t missed_lines = 0;
+    while (true)
+    {
+        sleep_ms(20);
+        s_frame++;
 
-#define RES_X 320
-#define RES_Y (SCAN_LINES - BORDER_TOP_LINES - BORDER_BOTTOM_LINES)
+        if (missed_lines != scanline_get_missed_lines())
+        {
+            missed_lines = scanline_get_missed_lines();
+            printf("missed lines: %lu\n", (unsigned long)missed_lines);
+        }
+    }
+}
+
+// The tile map and the sprites are 1 bit colour only.
+#if VIDEO_COLOR_BITS == 1
+
+// Two pixels in a byte.
+#define PAIR(a, b) ((a) | ((b) << 3))
+#define SOLID_TILE(c) {[0 ... TILE_BYTES - 1] = PAIR(c, c)}
+#define FRAMED_ROW(c) PAIR(BLACK, c), PAIR(c, c), PAIR(c, c), PAIR(c, BLACK)
+#define FRAMED_TILE(c) {0, 0, 0, 0, FRAMED_ROW(c), FRAMED_ROW(c), FRAMED_ROW(c), FRAMED_ROW(c), FRAMED_ROW(c), FRAMED_ROW(c), 0, 0, 0, 0}
+
+// Solid and framed tiles of each color, in flash.
+static const uint8_t s_tileset[16][TILE_BYTES] __attribute__((aligned(4))) = {
+    SOLID_TILE(BLACK), SOLID_TILE(RED), SOLID_TILE(GREEN), SOLID_TILE(YELLOW),
+    SOLID_TILE(BLUE), SOLID_TILE(MAGENTA), SOLID_TILE(CYAN), SOLID_TILE(WHITE),
+    FRAMED_TILE(BLACK), FRAMED_TILE(RED), FRAMED_TILE(GREEN), FRAMED_TILE(YELLOW),
+    FRAMED_TILE(BLUE), FRAMED_TILE(MAGENTA), FRAMED_TILE(CYAN), FRAMED_TILE(WHITE),
+};
 
-#define LINE_COUNT (RES_X >> 1) // 2 pixels per byte.
-#define FRAMEBUFFER_SIZE (LINE_COUNT * RES_Y)
+static void tilemap_demo(void)
+{
+    tilemap_init(&s_tileset[0][0]);
+    scanline_init(tilemap_render_line);
+    video_start();
 
-// I/O pins used
-#define CSYNC_PIN 16
-#define RED_PIN 18
-#define GREEN_PIN 19
-#define BLUE_PIN 20
+    // Rewrite the whole map once per second with a diagonal pattern of framed tiles.
+    uint step = 0;
+    while (true)
+    {
+        for (uint y = 0; y < TILEMAP_HEIGHT; y++)
+        {
+            for (uint x = 0; x < TILEMAP_WIDTH; x++)
+            {
+                tilemap_set(x, y, 8 + (x + y + step) % 8);
+            }
+        }
 
-// 1 bit per each color channel, so 8 color.
-#define BLACK 0
-#define RED 1
-#define GREEN 2
-#define YELLOW 3
-#define BLUE 4
-#define MAGENTA 5
-#define CYAN 6
-#define WHITE 7
+        step++;
+        sleep_ms(1000);
+    }
+}
 
-static const uint8_t s_colors[8] = {BLACK, RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN, WHITE};
+#define BALL_SIZE 16
 
-static uint8_t s_framebuffer[FRAMEBUFFER_SIZE];
-static const uint8_t* s_address_pointer[1] = {s_framebuffer};
-static const uint8_t s_border_color = BLACK;
+static uint8_t s_ball_storage[SPRITE_IMAGE_BYTES(BALL_SIZE, BALL_SIZE)];
+static struct sprite_image_t s_ball;
 
-struct control_block_t
+static void render_tiles_and_sprites(uint y, uint8_t* line)
 {
-    uint32_t ctrl;					// Must maps to al1_ctrl
-    const volatile void* read_addr; // Must maps to al1_read_addr
-    io_wo_32* write_addr;			// Must maps to al1_write_addr
-    uint32_t count;					// Must maps to al1_transfer_count_trig
-};
+    tilemap_render_line(y, line);
+    sprites_compose_line(y, line);
+}
 
-int main()
+static void sprites_demo(void)
 {
-    // Initialize stdio
-    stdio_init_all();
+    // A white ball with a red center, transparent corners.
+    uint8_t source[BALL_SIZE * BALL_SIZE];
+    for (int y = 0; y < BALL_SIZE; y++)
+    {
+        for (int x = 0; x < BALL_SIZE; x++)
+        {
+            const int dx = 2 * x + 1 - BALL_SIZE;
+            const int dy = 2 * y + 1 - BALL_SIZE;
+            const int distance = dx * dx + dy * dy;
+            source[y * BALL_SIZE + x] = distance > BALL_SIZE * BALL_SIZE ? 0xff : (distance < 32 ? RED : WHITE);
+        }
+    }
+    sprite_image_pack(&s_ball, s_ball_storage, source, BALL_SIZE, BALL_SIZE, 0xff);
 
-    // Try to set a freq close to pixel clock (6172840 Hz) * 20 => 123456800 Hz.
-    set_sys_clock_khz(125000, false);
+    int x[SPRITES_MAX], y[SPRITES_MAX], dx[SPRITES_MAX], dy[SPRITES_MAX];
+    for (int i = 0; i < SPRITES_MAX; i++)
+    {
+        x[i] = (i * 37) % (RES_X - BALL_SIZE);
+        y[i] = (i * 53) % (RES_Y - BALL_SIZE);
+        dx[i] = (i & 1) ? 1 : -1;
+        dy[i] = (i & 2) ? 1 : -1;
+        sprites_set(i, &s_ball, x[i], y[i]);
+    }
+
+    tilemap_init(&s_tileset[0][0]);
+    for (uint row = 0; row < TILEMAP_HEIGHT; row++)
+    {
+        for (uint column = 0; column < TILEMAP_WIDTH; column++)
+        {
+            tilemap_set(column, row, 8 + BLUE + ((column + row) & 1));
+        }
+    }
+    scanline_init(render_tiles_and_sprites);
+    video_start();
+
+    uint frame = 0;
+    while (true)
+    {
+        sleep_ms(20);
 
-    // Choose which PIO instance to use (there are two instances, each with 4 state machines)
-    PIO pio = pio0;
+        for (int i = 0; i < SPRITES_MAX; i++)
+        {
+            if (x[i] + dx[i] < 0 || x[i] + dx[i] > RES_X - BALL_SIZE)
+            {
+                dx[i] = -dx[i];
+            }
+            if (y[i] + dy[i] < 0 || y[i] + dy[i] > RES_Y - BALL_SIZE)
+            {
+                dy[i] = -dy[i];
+            }
+            x[i] += dx[i];
+            y[i] += dy[i];
+            sprites_move(i, x[i], y[i]);
+        }
 
-   // pio program offsets for the cysnc and the rgb.
-    const uint csync_offset = pio_add_program(pio, &csync_program);
-    const uint rgb_offset = pio_add_program(pio, &rgb_program);
+        if (++frame % 50 == 0)
+        {
+            const uint32_t line_cycles = (uint64_t)video_get_clock_plan()->sys_hz * 1000 / video_get_mode()->line_mhz;
+            printf("sprites: worst compose %lu/%lu cycles, max %u per line, %lu dropped, %lu missed lines\n",
+                   (unsigned long)sprites_get_worst_compose_cycles(), (unsigned long)line_cycles, sprites_get_max_per_line(),
+                   (unsigned long)sprites_get_dropped(), (unsigned long)scanline_get_missed_lines());
+        }
+    }
+}
 
-    // State machine for each program.
-    const uint csync_sm = 0;
-    const uint rgb_sm = 1;
+#endif
 
-    // Initialize each program.
-    csync_program_init(pio, csync_sm, csync_offset, CSYNC_PIN);
-    rgb_program_init(pio, rgb_sm, rgb_offset, RED_PIN);
+// A small checkered tile to blit around.
+static struct surface_t make_tile(void)
+{
+    static uint8_t tile_pixels[16 * DRAW_ROW_BYTES(16)] __attribute__((aligned(4)));
+    const struct surface_t tile = {tile_pixels, 16, 16, DRAW_ROW_BYTES(16)};
+    for (int i = 0; i < 4; i++)
+    {
+        draw_fill_rect(&tile, (i & 1) * 8, (i >> 1) * 8, 8, 8, (i == 0 || i == 3) ? WHITE : RED);
+    }
+    return tile;
+}
 
-    // Prepare the DMAs to do automatic data transfer.
-    struct control_block_t control_blocks[] = {
-        {0, &s_border_color, &pio->txf[rgb_sm], LINE_COUNT * BORDER_TOP_LINES},	   // top border
-        {0, s_framebuffer, &pio->txf[rgb_sm], LINE_COUNT * RES_Y},				   // real pixels
-        {0, &s_border_color, &pio->txf[rgb_sm], LINE_COUNT * BORDER_BOTTOM_LINES}, // botttom border
-    };
+static void draw_demo(void)
+{
+    framebuffer_init();
+    video_start();
 
-    const uint channel_0 = dma_claim_unused_channel(true); // Transfer color
-    const uint channel_1 = dma_claim_unused_channel(true); // Configure channel 1 to transfer top border + framebuffer + bottom border.
-    const uint channel_2 = dma_claim_unused_channel(true); // Restart channel 2.
+    const struct surface_t tile = make_tile();
 
+    int x = 0;
+    int dx = 3;
+    while (true)
     {
-        // Transfer colors to the PIO SM.
-        dma_channel_config cfg = dma_channel_get_default_config(channel_0); // default configs
-        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);			// 8-bit txfers
-        channel_config_set_read_increment(&cfg, true);						// yes read incrementing
-        channel_config_set_write_increment(&cfg, false);					// no write incrementing
-        channel_config_set_dreq(&cfg, pio_get_dreq(pio, rgb_sm, true));		// DREQ_PIO0_TX2 pacing (FIFO)
-        channel_config_set_irq_quiet(&cfg, true);
-        channel_config_set_chain_to(&cfg, channel_1);
+        const struct surface_t screen = {framebuffer_get_back(), RES_X, FRAME_Y, LINE_COUNT};
+        draw_clear(&screen, BLUE);
+        for (int i = 0; i < 8; i++)
+        {
+            draw_fill_rect(&screen, x + i * 5, 20 + i * 25, 60, 20, s_colors[i]);
+            draw_blit(&screen, RES_X - x - 16 - i * 7, 25 + i * 25, &tile, 0, 0, 16, 16);
+        }
+        draw_hline(&screen, 0, 0, RES_X, WHITE);
+        draw_hline(&screen, 0, FRAME_Y - 1, RES_X, WHITE);
+        draw_vline(&screen, 0, 0, FRAME_Y, WHITE);
+        draw_vline(&screen, RES_X - 1, 0, FRAME_Y, WHITE);
+
+        // Triple buffered the next picture is drawn while this one waits for the vertical blank.
+        framebuffer_flip();
+        if (FRAMEBUFFER_COUNT == 2)
+        {
+            framebuffer_wait_flip();
+        }
 
-        // ctrl for the pixels.
-        control_blocks[1].ctrl = cfg.ctrl;
+        if (x + dx < 0 || x + dx > RES_X - 100)
+        {
+            dx = -dx;
+        }
+        x += dx;
+    }
+}
+
+// Same picture as the draw demo, core 0 only queues the commands and core 1 draws them.
+static void render_demo(void)
+{
+    framebuffer_init();
+    render_init();
+    video_start();
 
-        // ctrl for the borders, the color is always the same so no read increment.
-        channel_config_set_read_increment(&cfg, false);
-        control_blocks[0].ctrl = cfg.ctrl;
+    static struct surface_t tile;
+    tile = make_tile();
 
-        // for the last entry set the chain to channel 2 to trigger it once transfering finishes.
-        channel_config_set_chain_to(&cfg, channel_2);
-        control_blocks[2].ctrl = cfg.ctrl;
+    int x = 0;
+    int dx = 3;
+    uint frame = 0;
+    while (true)
+    {
+        render_clear(BLUE);
+        for (int i = 0; i < 8; i++)
+        {
+            render_fill_rect(x + i * 5, 20 + i * 25, 60, 20, s_colors[i]);
+            render_blit(RES_X - x - 16 - i * 7, 25 + i * 25, &tile, 0, 0, 16, 16);
+        }
+        render_hline(0, 0, RES_X, WHITE);
+        render_hline(0, FRAME_Y - 1, RES_X, WHITE);
+        render_vline(0, 0, FRAME_Y, WHITE);
+        render_vline(RES_X - 1, 0, FRAME_Y, WHITE);
+        render_flip();
+
+        if (x + dx < 0 || x + dx > RES_X - 100)
+        {
+            dx = -dx;
+        }
+        x += dx;
+
+        // The logic of the next frame doesn't wait for the drawing, just for the next field.
+        video_wait_vblank();
+        if (++frame % 50 == 0)
+        {
+            struct render_stats_t stats;
+            render_get_stats(&stats);
+            printf("render: %u/%u queued, max %u, %lu run, %lu rejected\n", stats.occupancy, stats.depth, stats.max_occupancy,
+                   (unsigned long)stats.completed, (unsigned long)stats.rejected);
+        }
     }
+}
+
+// Lines of colour bands at the bottom of the indexed and raster demos.
+#define BAND_LINES 64
+#define BAR_INDEX (INDEXED_COLORS - 1)
 
+static void indexed_demo(void)
+{
+    // A new index every 4 pixels along the diagonal, drawn once, and the bottom band all one index.
+    indexed_init();
+    uint8_t* pixels = indexed_get_pixels();
+    for (uint y = 0; y < RES_Y; y++)
     {
-        // DMA channel 1 configure dma 0 (aka RGB data).
-        dma_channel_config cfg = dma_channel_get_default_config(channel_1);
-        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
-        channel_config_set_read_increment(&cfg, true);
-        channel_config_set_write_increment(&cfg, true);
-        channel_config_set_ring(&cfg, true, 4); // 16 byte boundary on write ptr
-        channel_config_set_irq_quiet(&cfg, true);
+        for (uint x = 0; x < RES_X; x++)
+        {
+            pixels[y * RES_X + x] = y < RES_Y - BAND_LINES ? (x + y) / 4 : BAR_INDEX;
+        }
+    }
 
-        dma_channel_configure(channel_1,
-                              &cfg,
-                              &dma_hw->ch[channel_0].al1_ctrl, // Initial write address
-                              control_blocks,				   // Initial read address
-                              4,							   // Halt after each control block
-                              false							   // Don't start yet
-        );
+    // Raster bars through that index: core 1 sets it again every 4 lines of the band.
+    for (uint y = RES_Y - BAND_LINES; y < RES_Y; y += 4)
+    {
+        indexed_add_line_color(y, BAR_INDEX, s_colors[(y / 4) % 8]);
     }
+    scanline_init(indexed_render_line);
+    video_start();
+
+    // Only the palette changes: 16 indices per colour band, the bands move one index per frame.
+    uint16_t palette[BAR_INDEX];
+    uint step = 0;
+    while (true)
+    {
+        for (uint i = 0; i < BAR_INDEX; i++)
+        {
+            palette[i] = s_colors[((i + step) / 16) % 8];
+        }
+        indexed_set_palette(0, palette, BAR_INDEX);
 
-    const volatile void* control_block_ptr[] = {control_blocks};
+        step++;
+        sleep_ms(20);
+        if (step % 50 == 0)
+        {
+            struct indexed_budget_t budget;
+            indexed_get_budget(&budget);
+            printf("indexed: worst line %lu/%lu cycles, %lu per palette change, %u changes per line\n",
+                   (unsigned long)budget.worst_render_cycles, (unsigned long)budget.line_cycles, (unsigned long)budget.change_cycles,
+                   budget.changes_per_line);
+        }
+    }
+}
 
+static void dither_demo(void)
+{
+    // The phases take turns in two buffers.
+    hard_assert(FRAMEBUFFER_COUNT == 2);
+    framebuffer_init();
+
+    // Red across, green down, blue along the diagonal, a line of 24 bits at a time: phase 0 into
+    // the front framebuffer and phase 1 into the back one.
+    static uint8_t rgb[RES_X * 3];
+    uint32_t us = 0;
+    for (uint phase = 0; phase < DITHER_PHASES; phase++)
     {
-        // DMA Channel 2: restarts the DMA channel 1
-        dma_channel_config cfg = dma_channel_get_default_config(channel_2); // default configs
-        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);			// 32-bit txfers
-        channel_config_set_read_increment(&cfg, false);						// no read incrementing
-        channel_config_set_write_increment(&cfg, false);					// no write incrementing
-        channel_config_set_irq_quiet(&cfg, true);
+        uint8_t* framebuffer = phase ? framebuffer_get_back() : framebuffer_get_front();
+        for (uint y = 0; y < FRAME_Y; y++)
+        {
+            for (uint x = 0; x < RES_X; x++)
+            {
+                rgb[x * 3] = x * 255 / (RES_X - 1);
+                rgb[x * 3 + 1] = y * 255 / (FRAME_Y - 1);
+                rgb[x * 3 + 2] = (rgb[x * 3] + 255 - rgb[x * 3 + 1]) / 2;
+            }
 
-        dma_channel_configure(channel_2,								 // Channel to be configured
-                              &cfg,										 // The configuration we just created
-                              &dma_hw->ch[channel_1].al3_read_addr_trig, // Write address (channel 1 read address)
-                              control_block_ptr,						 // Read address (POINTER TO AN ADDRESS)
-                              1,										 // Number of transfers, in this case each is 4 byte
-                              false										 // Don't start immediately.
-        );
+            const uint32_t start = time_us_32();
+            dither_line(framebuffer_get_line(framebuffer, y), rgb, RES_X, y, phase);
+            us += time_us_32() - start;
+        }
     }
+    us /= DITHER_PHASES;
+    printf("dither: %lu us per picture, %lu kpixel/s\n", (unsigned long)us, (unsigned long)(RES_X * FRAME_Y * 1000ull / us));
 
-    /////////////////////////////////////////////////////////////////////////////////////////////////////
-    /////////////////////////////////////////////////////////////////////////////////////////////////////
+    video_start();
 
-    // Feed each state machine with the initial data.
-    pio_sm_put_blocking(pio, csync_sm, SCAN_LINES - 1);
-    pio_sm_put_blocking(pio, rgb_sm, (RES_X >> 1) - 2);
+    // Temporal dithering: a flip every field shows the phases in turn.
+    while (true)
+    {
+        framebuffer_flip();
+        framebuffer_wait_flip();
+    }
+}
 
-    // Enable the state machines.
-    pio_enable_sm_mask_in_sync(pio, (1u << csync_sm) | (1u << rgb_sm));
+#define HUD_LINES 24
+#define PLAYFIELD_ROWS 16
 
-    // Start DMA channel 1 to transfer the control blocks to dma which will send the RGB data.
-    dma_start_channel_mask((1u << channel_1));
+static void raster_demo(void)
+{
+    // A HUD for the top lines, the last one is sent with a word more too.
+    static uint8_t hud[HUD_LINES * LINE_COUNT + 4] __attribute__((aligned(4)));
+    const struct surface_t hud_surface = {hud, RES_X, HUD_LINES, LINE_COUNT};
+    draw_clear(&hud_surface, BLUE);
+    for (int i = 0; i < 8; i++)
+    {
+        draw_fill_rect(&hud_surface, 8 + i * 24, 6, 16, 12, s_colors[i]);
+    }
 
-   // Feed the framebuffer with some vertical color bars.
+    // 16 rows of a playfield twice as wide as the screen, repeated down to the bands.
+    static uint8_t playfield[PLAYFIELD_ROWS * 2 * LINE_COUNT] __attribute__((aligned(4)));
+    const struct surface_t field = {playfield, 2 * RES_X, PLAYFIELD_ROWS, 2 * LINE_COUNT};
+    for (int x = 0; x < 2 * RES_X; x += 40)
     {
-        uint color_index = 0;
-        uint32_t vbar_length = 0;
-        uint32_t x = 0;
-        uint32_t y = 0;
-        for (y = 0; y < RES_Y; y++)
+        draw_fill_rect(&field, x, 0, 40, PLAYFIELD_ROWS / 2, s_colors[(x / 40) % 8]);
+        draw_fill_rect(&field, x, PLAYFIELD_ROWS / 2, 40, PLAYFIELD_ROWS / 2, s_colors[(x / 40 + 4) % 8]);
+    }
+
+    raster_init();
+    video_start();
+
+    // The playfield scrolls a pixel per field, the bands a line.
+    uint offset = 0;
+    uint frame = 0;
+    while (true)
+    {
+        struct raster_line_t* lines = raster_get_back();
+        for (uint y = 0; y < RES_Y; y++)
         {
-            for (x = 0; x < RES_X; x++)
+            if (y < HUD_LINES)
+            {
+                lines[y] = (struct raster_line_t){hud + y * LINE_COUNT, 0, 0};
+            }
+            else if (y < RES_Y - BAND_LINES)
             {
-                // vertical bar of 40 pixels
-                if (vbar_length == 40)
-                {
-                    vbar_length = 0;
-                    color_index = (color_index + 1) % 8;
-                }
-                vbar_length += 1;
-
-                const uint8_t color = s_colors[color_index];
-                const uint32_t offset = ((RES_X * y) + x);
-                if (offset & 1)
-                {
-                    s_framebuffer[offset >> 1] |= (color << 3);
-                }
-                else
-                {
-                    s_framebuffer[offset >> 1] |= color;
-                }
+                const uint row = (y - HUD_LINES) % PLAYFIELD_ROWS;
+                lines[y] = (struct raster_line_t){playfield + row * 2 * LINE_COUNT, offset, 0};
             }
+            else
+            {
+                lines[y] = (struct raster_line_t){NULL, 0, s_colors[((y + frame) / 8) % 8]};
+            }
+        }
+
+        // Bars running the other way in the borders.
+        uint16_t* border = raster_get_back_border();
+        for (uint i = 0; i < RASTER_BORDER_LINES; i++)
+        {
+            border[i] = s_colors[((i + RASTER_BORDER_LINES - frame % RASTER_BORDER_LINES) / 4) % 8];
         }
+        raster_commit();
+        raster_wait_commit();
+
+        offset = (offset + 1) % RES_X;
+        frame++;
     }
+}
+
+static void framebuffer_demo(void)
+{
+    framebuffer_init();
+    video_start();
 
+    // Fill the whole ring, every 30 rows the bars start one color later.
+    uint8_t* framebuffer = framebuffer_get_front();
+    uint row = 0;
+    for (row = 0; row < FRAMEBUFFER_LINES; row++)
+    {
+        draw_color_bars(framebuffer + row * LINE_COUNT, (row / 30) % 8);
+    }
+
+    // Scroll up one line per frame, only the row coming in at the bottom is drawn.
+    uint scroll = 0;
     while (true)
     {
+        draw_color_bars(framebuffer_get_line(framebuffer, FRAME_Y), (row / 30) % 8);
+        row++;
+
+        scroll = (scroll + 1) % FRAMEBUFFER_LINES;
+        framebuffer_set_scroll(scroll);
+        while (framebuffer_scroll_pending())
+        {
+            tight_loop_contents();
+        }
+    }
+}
+
+int main()
+{
+    // The system clock may change, stdio after it.
+    video_init(&MODE);
+
+    // Initialize stdio
+    stdio_init_all();
+
+    const struct clock_plan_t* plan = video_get_clock_plan();
+    printf("%s: sys %lu Hz, line %+ld ppb, pixel %+ld ppb%s\n", MODE.name, (unsigned long)plan->sys_hz, (long)plan->csync_error_ppb,
+           (long)plan->rgb_error_ppb, video_clock_in_tolerance() ? "" : " (out of tolerance)");
+
+    switch (DEMO)
+    {
+    case DEMO_SCANLINE:
+        scanline_demo();
+        break;
+#if VIDEO_COLOR_BITS == 1
+    case DEMO_TILEMAP:
+        tilemap_demo();
+        break;
+    case DEMO_SPRITES:
+        sprites_demo();
+        break;
+#endif
+    case DEMO_DRAW:
+        draw_demo();
+        break;
+    case DEMO_INDEXED:
+        indexed_demo();
+        break;
+    case DEMO_DITHER:
+        dither_demo();
+        break;
+    case DEMO_RENDER:
+        render_demo();
+        break;
+    case DEMO_RASTER:
+        raster_demo();
+        break;
+    default:
+        framebuffer_demo();
+        break;
     }
 }
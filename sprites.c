@@ -0,0 +1,225 @@
+/**
+ * Sprites for the scanline mode, see sprites.h.
+ */
+#include "sprites.h"
+
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+#include <string.h>
+
+struct sprite_t
+{
+    const struct sprite_image_t* image; // NULL when hidden.
+    int16_t x;
+    int16_t y;
+};
+
+// Core 0 changes s_sprites, core 1 composes from one of the two copies in s_shown and copies s_sprites into the
+// other one before the first line of a frame. s_changes is odd while core 0 is in the middle of a change, a copy
+// taken meanwhile or during which it moved is thrown away and taken again the next frame.
+static struct sprite_t s_sprites[SPRITES_MAX];
+static volatile uint32_t s_changes = 0;
+static struct sprite_t s_shown[2][SPRITES_MAX];
+static uint s_front = 0;
+static uint32_t s_shown_changes = 0;
+
+static volatile uint32_t s_dropped = 0;
+static volatile uint s_max_per_line = 0;
+
+// Cycles measured on core 1 with its SysTick, set up on the first line it composes.
+static volatile uint32_t s_worst_compose_cycles = 0;
+static bool s_timing_ready = false;
+
+void sprite_image_pack(struct sprite_image_t* image, uint8_t* storage, const uint8_t* source, uint width, uint height, uint8_t transparent)
+{
+    hard_assert(VIDEO_COLOR_BITS == 1); // Bytes of 2 pixels, like the tile map.
+    const uint row_bytes = SPRITE_ROW_BYTES(width);
+    uint8_t* pixels = storage;
+    uint8_t* masks = storage + 2 * height * row_bytes;
+    memset(storage, 0, SPRITE_IMAGE_BYTES(width, height));
+
+    for (uint odd = 0; odd < 2; odd++)
+    {
+        for (uint y = 0; y < height; y++)
+        {
+            uint8_t* pixel_row = pixels + (odd * height + y) * row_bytes;
+            uint8_t* mask_row = masks + (odd * height + y) * row_bytes;
+
+            for (uint x = 0; x < width; x++)
+            {
+                const uint8_t color = source[y * width + x];
+                if (color != transparent)
+                {
+                    // Same layout as the framebuffer: even pixel in bits 0-2, odd pixel in bits 3-5.
+                    const uint position = x + odd;
+                    const uint shift = (position & 1) * 3;
+                    pixel_row[position >> 1] |= (color & 7) << shift;
+                    mask_row[position >> 1] |= 7 << shift;
+                }
+            }
+        }
+    }
+
+    image->width = width;
+    image->height = height;
+    image->row_bytes = row_bytes;
+    image->pixels = pixels;
+    image->masks = masks;
+}
+
+static inline void begin_change(uint index)
+{
+    hard_assert(index < SPRITES_MAX);
+    s_changes++;
+    __dmb();
+}
+
+static inline void end_change(void)
+{
+    __dmb();
+    s_changes++;
+}
+
+void sprites_set(uint index, const struct sprite_image_t* image, int x, int y)
+{
+    begin_change(index);
+    s_sprites[index].x = x;
+    s_sprites[index].y = y;
+    s_sprites[index].image = image;
+    end_change();
+}
+
+void sprites_move(uint index, int x, int y)
+{
+    begin_change(index);
+    s_sprites[index].x = x;
+    s_sprites[index].y = y;
+    end_change();
+}
+
+void sprites_hide(uint index)
+{
+    begin_change(index);
+    s_sprites[index].image = NULL;
+    end_change();
+}
+
+// The changes of core 0 since the last frame, if none is under way.
+static void publish(void)
+{
+    const uint32_t changes = s_changes;
+    if (changes == s_shown_changes || (changes & 1))
+    {
+        return;
+    }
+
+    __dmb();
+    memcpy(s_shown[s_front ^ 1], s_sprites, sizeof(s_sprites));
+    __dmb();
+    if (s_changes == changes)
+    {
+        s_front ^= 1;
+        s_shown_changes = changes;
+    }
+}
+
+// The 24-bit SysTick of the core counts the system clock down.
+static inline uint32_t cycles_since(uint32_t start)
+{
+    return (start - systick_hw->cvr) & 0xffffff;
+}
+
+static void setup_timing(void)
+{
+    systick_hw->rvr = 0xffffff;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // Enabled, system clock.
+}
+
+static void __not_in_flash_func(draw_sprite_row)(const struct sprite_t* sprite, uint row, uint8_t* line)
+{
+    const struct sprite_image_t* image = sprite->image;
+    const uint odd = sprite->x & 1;
+    const uint8_t* pixels = image->pixels + (odd * image->height + row) * image->row_bytes;
+    const uint8_t* masks = image->masks + (odd * image->height + row) * image->row_bytes;
+
+    // Clip the packed row against the line.
+    const int first_byte = (sprite->x - (int)odd) / 2;
+    const int begin = MAX(0, -first_byte);
+    const int end = MIN((int)image->row_bytes, LINE_COUNT - first_byte);
+
+    uint8_t* out = line + first_byte;
+    for (int i = begin; i < end; i++)
+    {
+        out[i] = (out[i] & ~masks[i]) | pixels[i];
+    }
+}
+
+void __not_in_flash_func(sprites_compose_line)(uint y, uint8_t* line)
+{
+    if (!s_timing_ready)
+    {
+        setup_timing();
+        s_timing_ready = true;
+    }
+    if (y == 0)
+    {
+        publish();
+    }
+    const uint32_t start = systick_hw->cvr;
+
+    // Sprites on this line, by priority.
+    const struct sprite_t* visible[SPRITES_PER_LINE];
+    uint count = 0;
+    uint found = 0;
+    for (uint i = 0; i < SPRITES_MAX; i++)
+    {
+        const struct sprite_t* sprite = &s_shown[s_front][i];
+        if (sprite->image && (int)y >= sprite->y && (int)y < sprite->y + sprite->image->height &&
+            sprite->x < RES_X && sprite->x + sprite->image->width > 0)
+        {
+            found++;
+            if (count < SPRITES_PER_LINE)
+            {
+                visible[count++] = sprite;
+            }
+        }
+    }
+
+    // Lowest index last so it ends on top.
+    while (count > 0)
+    {
+        const struct sprite_t* sprite = visible[--count];
+        draw_sprite_row(sprite, y - sprite->y, line);
+    }
+
+    if (found > SPRITES_PER_LINE)
+    {
+        s_dropped += found - SPRITES_PER_LINE;
+    }
+    if (found > s_max_per_line)
+    {
+        s_max_per_line = found;
+    }
+
+    const uint32_t cycles = cycles_since(start);
+    if (cycles > s_worst_compose_cycles)
+    {
+        s_worst_compose_cycles = cycles;
+    }
+}
+
+uint32_t sprites_get_dropped(void)
+{
+    return s_dropped;
+}
+
+uint sprites_get_max_per_line(void)
+{
+    return s_max_per_line;
+}
+
+uint32_t sprites_get_worst_compose_cycles(void)
+{
+    return s_worst_compose_cycles;
+}
@@ -0,0 +1,56 @@
+/**
+ * Sprites for the scanline mode.
+ *
+ * Up to SPRITES_MAX sprites are composited into the line buffer right after the background
+ * has been rendered, so nothing is ever erased or redrawn in a framebuffer. Like hardware
+ * sprites there is a limit of SPRITES_PER_LINE per line: lower indices have priority (and are
+ * drawn on top), the others are dropped on that line and counted.
+ *
+ * Sprite images are packed beforehand in the framebuffer format (2 pixels per byte) together
+ * with a mask of the opaque pixels, once for even and once for odd x positions, so drawing a
+ * sprite row is a masked byte copy without any per pixel work.
+ *
+ * Core 0 sets and moves sprites while core 1 composes, the changes show from the next frame on.
+ */
+#ifndef SPRITES_H
+#define SPRITES_H
+
+#include "video.h"
+
+#define SPRITES_MAX 32
+#define SPRITES_PER_LINE 16
+
+// Bytes a packed row takes and storage needed by sprite_image_pack().
+#define SPRITE_ROW_BYTES(width) (((width) >> 1) + 1)
+#define SPRITE_IMAGE_BYTES(width, height) (4 * (height) * SPRITE_ROW_BYTES(width))
+
+struct sprite_image_t
+{
+    uint16_t width;
+    uint16_t height;
+    uint16_t row_bytes;
+    const uint8_t* pixels; // [2][height][row_bytes], for even and odd x.
+    const uint8_t* masks;  // same layout, the color bits of the opaque pixels set.
+};
+
+// Pack width x height pixels, one color per byte, any byte equal to `transparent` is see through.
+// storage must hold SPRITE_IMAGE_BYTES(width, height) and stay alive as long as the image.
+void sprite_image_pack(struct sprite_image_t* image, uint8_t* storage, const uint8_t* source, uint width, uint height, uint8_t transparent);
+
+// Show sprite `index` (below SPRITES_MAX) with the given image, x and y of its top left corner can be off screen.
+void sprites_set(uint index, const struct sprite_image_t* image, int x, int y);
+void sprites_move(uint index, int x, int y);
+void sprites_hide(uint index);
+
+// Composite the sprites over visible line y, call it from the scanline render function after the background.
+void sprites_compose_line(uint y, uint8_t* line);
+
+// Sprite lines dropped because of the per line limit, and the most sprites found on a single line.
+uint32_t sprites_get_dropped(void);
+uint sprites_get_max_per_line(void);
+
+// Most system clock cycles sprites_compose_line() took for a line, measured with the SysTick of core 1. A line
+// of the mode lasts sys_hz / line frequency of them (8000 at 125 MHz in PAL), the background has to fit as well.
+uint32_t sprites_get_worst_compose_cycles(void);
+
+#endif
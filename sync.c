@@ -0,0 +1,157 @@
+/**
+ * Sync pulse tables, see sync.h.
+ */
+#include "sync.h"
+
+// Instructions exec'd by csync.pio, the delay goes in bits 8-12.
+#define SET_PINS(level) (0xe000 | (level))
+#define IRQ(index) (0xc000 | (index))
+#define IRQ_0 IRQ(0)
+#define NOP 0xa042 // mov y, y
+#define DELAY(tics) (((tics) - 2) << 8)
+#define MAX_TICS 33 // 2 + the largest delay.
+#define DELAY_MASK 0x1f00
+
+// Hsync 5 us, pixels from 18 us (the left border included). Broad and equalising pulses a bit
+// longer than the 27.3 / 2.35 us of the standard, every TV tried locks to them fine.
+const struct sync_timing_t sync_pal_timing = {5, 30, 2, 18};
+
+const struct sync_field_t sync_pal_progressive[1] = {
+    {5, 5, false, 304, false, 6},
+};
+
+// Field 1: lines 1-312.5, field 2: lines 313-625 with a half line after its equalising pulses and
+// another one (line 623) before the next field.
+const struct sync_field_t sync_pal_interlaced[2] = {
+    {5, 5, false, 305, false, 5},
+    {5, 5, true, 304, true, 5},
+};
+
+// 6 pulses of each kind. The same tics as PAL are 0.7% shorter, the broad pulses are made shorter
+// still to leave the serration of the standard (4.7 us).
+const struct sync_timing_t sync_ntsc_timing = {5, 27, 2, 18};
+
+const struct sync_field_t sync_ntsc_progressive[1] = {
+    {6, 6, false, 253, false, 6},
+};
+
+// Field 1 ends with a half line, field 2 starts with one.
+const struct sync_field_t sync_ntsc_interlaced[2] = {
+    {6, 6, false, 253, true, 6},
+    {6, 6, true, 253, false, 6},
+};
+
+struct writer_t
+{
+    uint16_t* table;
+    unsigned capacity;
+    unsigned count;
+    uint16_t* marks;
+    unsigned lines;
+};
+
+// Run the instruction and then nothing for a total of tics.
+static bool emit(struct writer_t* writer, uint16_t instruction, unsigned tics)
+{
+    while (tics > 0)
+    {
+        // Always leave at least 2 tics for the next entry.
+        unsigned length = tics;
+        if (length > MAX_TICS)
+        {
+            length = (tics - MAX_TICS >= 2) ? MAX_TICS : MAX_TICS - 2;
+        }
+
+        if (writer->count == writer->capacity)
+        {
+            return false;
+        }
+        writer->table[writer->count++] = instruction | DELAY(length);
+        instruction = NOP;
+        tics -= length;
+    }
+    return true;
+}
+
+// Low for low tics and high for the rest of the given tics.
+static bool emit_pulse(struct writer_t* writer, unsigned low, unsigned tics)
+{
+    return emit(writer, SET_PINS(0), low) && emit(writer, SET_PINS(1), tics - low);
+}
+
+static bool emit_pulses(struct writer_t* writer, unsigned count, unsigned low)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (!emit_pulse(writer, low, SYNC_HALF_LINE_TICS))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool emit_field(struct writer_t* writer, const struct sync_timing_t* timing, const struct sync_field_t* field)
+{
+    if (!emit_pulses(writer, field->broad, timing->broad) || !emit_pulses(writer, field->post_equalising, timing->equalising))
+    {
+        return false;
+    }
+    if (field->half_line_after && !emit(writer, SET_PINS(1), SYNC_HALF_LINE_TICS))
+    {
+        return false;
+    }
+
+    for (unsigned i = 0; i < field->lines; i++)
+    {
+        if (!emit(writer, SET_PINS(0), timing->hsync) || !emit(writer, SET_PINS(1), 2))
+        {
+            return false;
+        }
+
+        // The mark, a nop until sync_set_mark().
+        if (writer->marks)
+        {
+            if (writer->lines == SYNC_MAX_LINES)
+            {
+                return false;
+            }
+            writer->marks[writer->lines++] = writer->count;
+        }
+        if (!emit(writer, NOP, timing->irq - timing->hsync - 2) || !emit(writer, IRQ_0, SYNC_LINE_TICS - timing->irq))
+        {
+            return false;
+        }
+    }
+
+    if (field->half_line && !emit_pulse(writer, timing->hsync, SYNC_HALF_LINE_TICS))
+    {
+        return false;
+    }
+    return emit_pulses(writer, field->pre_equalising, timing->equalising);
+}
+
+unsigned sync_build(uint16_t* table, unsigned capacity, const struct sync_timing_t* timing, const struct sync_field_t* fields,
+                    unsigned field_count, uint16_t* marks)
+{
+    // The mark has to be a single entry between the end of hsync and irq 0.
+    if (timing->irq < timing->hsync + 4 || timing->irq - timing->hsync - 2 > MAX_TICS)
+    {
+        return 0;
+    }
+
+    struct writer_t writer = {table, capacity, 0, marks, 0};
+    for (unsigned i = 0; i < field_count; i++)
+    {
+        if (!emit_field(&writer, timing, &fields[i]))
+        {
+            return 0;
+        }
+    }
+    return writer.count;
+}
+
+void sync_set_mark(uint16_t* table, unsigned index, int irq)
+{
+    table[index] = (table[index] & DELAY_MASK) | (irq < 0 ? NOP : IRQ(irq));
+}
@@ -0,0 +1,72 @@
+/**
+ * Sync pulse tables for the csync state machine.
+ *
+ * csync.pio is a sequencer: every 16-bit entry of a table is a PIO instruction (set pins, irq or
+ * nop, with its delay) run with out exec, so each entry lasts 2 + delay csync tics. A table holds
+ * all the fields of a frame and the DMA sends it over and over, so progressive, interlaced or
+ * any other line structure is just a different table.
+ *
+ * Each line with irq 0 has a mark entry in its horizontal blanking, right after the hsync
+ * pulse: a nop that sync_set_mark() turns into an irq of another flag in place, so the CPU
+ * can be interrupted at any line without rebuilding the table.
+ *
+ * Plain C without the SDK so tools/pio_sim builds the very same tables.
+ */
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SYNC_LINE_TICS 64 // 1 tic = 1 us with the csync state machine at 1 MHz for PAL, 63.556 / 64 us for NTSC.
+#define SYNC_HALF_LINE_TICS (SYNC_LINE_TICS / 2)
+
+// Entries of a PAL interlaced frame, the longest table, and its lines with irq 0.
+#define SYNC_TABLE_SIZE 3200
+#define SYNC_MAX_LINES 610
+
+// Pulse widths in tics.
+struct sync_timing_t
+{
+    uint8_t hsync;		// Low at the start of each line.
+    uint8_t broad;		// Low of the vertical sync pulses.
+    uint8_t equalising; // Low of the pulses around them.
+    uint8_t irq;		// From the hsync falling edge to irq 0, where the rgb state machine starts the pixels, 4 more than hsync at least.
+};
+
+// A field: vertical sync pulses, lines and the equalising pulses before the next field. Pulses are half a line apart.
+struct sync_field_t
+{
+    uint8_t broad;
+    uint8_t post_equalising;
+    bool half_line_after; // A half line without sync after the equalising pulses (second field of interlaced).
+    uint16_t lines;		  // Lines with hsync and irq 0.
+    bool half_line;		  // A half line with hsync but no pixels before the next pulses (second field of interlaced).
+    uint8_t pre_equalising;
+};
+
+extern const struct sync_timing_t sync_pal_timing;
+
+// 312 lines, the same picture every field.
+extern const struct sync_field_t sync_pal_progressive[1];
+
+// 625 lines in two fields of 312.5, the second one half a line lower (576i).
+extern const struct sync_field_t sync_pal_interlaced[2];
+
+extern const struct sync_timing_t sync_ntsc_timing;
+
+// 262 lines (240p).
+extern const struct sync_field_t sync_ntsc_progressive[1];
+
+// 525 lines in two fields of 262.5 (480i).
+extern const struct sync_field_t sync_ntsc_interlaced[2];
+
+// Fill the table with the fields, one after the other. Returns the number of entries, 0 if they don't fit.
+// marks (SYNC_MAX_LINES of them, or NULL) gets the index of the mark entry of each line with irq 0, field after field.
+unsigned sync_build(uint16_t* table, unsigned capacity, const struct sync_timing_t* timing, const struct sync_field_t* fields,
+                    unsigned field_count, uint16_t* marks);
+
+// Make the mark entry at index raise irq flag `irq` (1 to 7), or nothing with -1. It lasts the same either way.
+void sync_set_mark(uint16_t* table, unsigned index, int irq);
+
+#endif
@@ -0,0 +1,51 @@
+/**
+ * Tile map / character cell graphics, see tilemap.h.
+ */
+#include "tilemap.h"
+
+#include <string.h>
+
+static uint8_t s_map[TILEMAP_HEIGHT][TILEMAP_WIDTH];
+static const uint8_t* s_tileset;
+
+void tilemap_init(const uint8_t* tileset)
+{
+    hard_assert(VIDEO_COLOR_BITS == 1); // Tiles are bytes of 2 pixels.
+    s_tileset = tileset;
+}
+
+uint8_t* tilemap_get_map(void)
+{
+    return &s_map[0][0];
+}
+
+void tilemap_set(uint x, uint y, uint8_t tile)
+{
+    s_map[y][x] = tile;
+}
+
+void tilemap_fill(uint8_t tile)
+{
+    memset(s_map, tile, sizeof(s_map));
+}
+
+void tilemap_print(uint x, uint y, const char* text)
+{
+    for (; *text && x < TILEMAP_WIDTH; text++, x++)
+    {
+        s_map[y][x] = (uint8_t)*text;
+    }
+}
+
+void __not_in_flash_func(tilemap_render_line)(uint y, uint8_t* line)
+{
+    const uint8_t* row = s_map[y / TILE_SIZE];
+    const uint8_t* tileset = s_tileset + (y % TILE_SIZE) * TILE_ROW_BYTES;
+    uint32_t* out = (uint32_t*)line;
+
+    // One word per tile.
+    for (uint x = 0; x < TILEMAP_WIDTH; x++)
+    {
+        out[x] = *(const uint32_t*)(tileset + row[x] * TILE_BYTES);
+    }
+}
@@ -0,0 +1,43 @@
+/**
+ * Tile map / character cell graphics for the scanline mode.
+ *
+ * The screen is a TILEMAP_WIDTH x TILEMAP_HEIGHT map of tile indices (1.2 KB) over a
+ * shared tile set, usually const so it stays in flash. tilemap_render_line() is a
+ * scanline_render_t that expands the tiles of one line straight into the line buffer,
+ * so rewriting the map is all it takes to update the whole screen.
+ *
+ * Tiles are TILE_SIZE x TILE_SIZE pixels in the framebuffer format (2 pixels per byte),
+ * row after row: TILE_BYTES each, a tile row is a single 32-bit word. Text is just tiles
+ * indexed by character code, see tilemap_print().
+ */
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include "video.h"
+
+#define TILE_SIZE 8
+#define TILE_ROW_BYTES (TILE_SIZE >> 1) // 2 pixels per byte.
+#define TILE_BYTES (TILE_ROW_BYTES * TILE_SIZE)
+
+#define TILEMAP_WIDTH (RES_X / TILE_SIZE)
+#define TILEMAP_HEIGHT (RES_Y / TILE_SIZE)
+
+// Use the given tile set, up to 256 tiles of TILE_BYTES. It must be 4 byte aligned and stay alive.
+void tilemap_init(const uint8_t* tileset);
+
+// The map itself, TILEMAP_WIDTH tile indices per row. Can be written at any time.
+uint8_t* tilemap_get_map(void);
+
+// Set the tile at the given cell.
+void tilemap_set(uint x, uint y, uint8_t tile);
+
+// Fill the whole map with a tile.
+void tilemap_fill(uint8_t tile);
+
+// Write the characters of text as tile indices from the given cell, clipped at the end of the row.
+void tilemap_print(uint x, uint y, const char* text);
+
+// scanline_render_t: expand the tiles of visible line y.
+void tilemap_render_line(uint y, uint8_t* line);
+
+#endif
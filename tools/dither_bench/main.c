@@ -0,0 +1,197 @@
+/**
+ * Measure how fast dither.c converts a 24-bit picture into the framebuffer format, on the host.
+ *
+ * Usage: dither_bench [-n <pictures>] [--size <width>x<height>] [--png <file>] [--temporal]
+ *
+ * The picture is a set of gradients, converted n times (both phases in turn) into a buffer of
+ * the framebuffer format of the build (dither_bench, dither_bench_dense, dither_bench_15bit).
+ * --png writes the result back in 24 bits, phase 0 or with --temporal the average of both
+ * phases, what the eye sees of a picture shown in alternate fields.
+ *
+ * First it counts the shades of a channel: the distinct averages over the 4x4 matrix of grey
+ * pictures of each value, with phase 0 and with both phases, and exits with 1 if the phases
+ * don't add the thresholds in between (LEVELS * 16 shades plus black, twice as many with both).
+ */
+#include "dither.h"
+#include "png.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LEVELS ((1u << VIDEO_COLOR_BITS) - 1)
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#define ROW_BYTES(width)                                                                                                               \
+    (VIDEO_COLOR_BITS > 1 ? ((width) + 1) / 2 * 4 : VIDEO_DENSE_PIXELS ? ((width) + 9) / 10 * 4 : ((width) + 1) / 2)
+
+// Red across, green down, blue along the diagonal.
+static void make_picture(uint8_t* rgb, unsigned width, unsigned height)
+{
+    for (unsigned y = 0; y < height; y++)
+    {
+        for (unsigned x = 0; x < width; x++, rgb += 3)
+        {
+            rgb[0] = x * 255 / (width - 1);
+            rgb[1] = y * 255 / (height - 1);
+            rgb[2] = (x * 255 / (width - 1) + (height - 1 - y) * 255 / (height - 1)) / 2;
+        }
+    }
+}
+
+static unsigned get_pixel(const uint8_t* row, unsigned x)
+{
+#if VIDEO_COLOR_BITS > 1
+    return ((const uint16_t*)row)[x];
+#elif VIDEO_DENSE_PIXELS
+    return (((const uint32_t*)row)[x / 10] >> ((x % 10) * 3)) & 7;
+#else
+    return (row[x >> 1] >> ((x & 1) * 3)) & 7;
+#endif
+}
+
+// Add the 0-255 channels of the pixels to sum.
+static void accumulate(unsigned* sum, const uint8_t* pixels, unsigned stride, unsigned width, unsigned height)
+{
+    for (unsigned y = 0; y < height; y++)
+    {
+        for (unsigned x = 0; x < width; x++)
+        {
+            const unsigned code = get_pixel(pixels + y * stride, x);
+            for (unsigned c = 0; c < 3; c++)
+            {
+                *sum++ += ((code >> (c * VIDEO_COLOR_BITS)) & LEVELS) * 255 / LEVELS;
+            }
+        }
+    }
+}
+
+// Distinct sums of a channel over the matrix, with the first phases phases, of 256 grey values.
+static unsigned count_shades(unsigned phases)
+{
+    uint8_t rgb[4 * 4 * 3];
+    uint8_t pixels[ROW_BYTES(4) * 4] __attribute__((aligned(4))) = {0};
+    bool seen[LEVELS * 16 * DITHER_PHASES + 1] = {false};
+    unsigned count = 0;
+    for (unsigned v = 0; v < 256; v++)
+    {
+        memset(rgb, v, sizeof(rgb));
+        unsigned sum = 0;
+        for (unsigned phase = 0; phase < phases; phase++)
+        {
+            dither_image(pixels, ROW_BYTES(4), rgb, 4 * 3, 4, 4, phase);
+            for (unsigned i = 0; i < 16; i++)
+            {
+                sum += get_pixel(pixels + (i / 4) * ROW_BYTES(4), i % 4) & LEVELS;
+            }
+        }
+        count += !seen[sum];
+        seen[sum] = true;
+    }
+    return count;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned pictures = 500;
+    unsigned width = 320;
+    unsigned height = 240;
+    const char* png_path = NULL;
+    bool temporal = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            pictures = (unsigned)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%ux%u", &width, &height) != 2 || width < 2 || height < 2)
+            {
+                fprintf(stderr, "%s: <width>x<height>\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "--png") == 0 && i + 1 < argc)
+        {
+            png_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--temporal") == 0)
+        {
+            temporal = true;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n <pictures>] [--size <width>x<height>] [--png <file>] [--temporal]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const unsigned stride = ROW_BYTES(width);
+    uint8_t* rgb = malloc((size_t)width * height * 3);
+    uint8_t* pixels = calloc((size_t)stride * height, 1);
+    unsigned* sum = calloc((size_t)width * height * 3, sizeof(unsigned));
+    if (!rgb || !pixels || !sum)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    make_picture(rgb, width, height);
+
+    // As many as the thresholds allow or one per grey value.
+    const unsigned shades = count_shades(1);
+    const unsigned temporal_shades = count_shades(DITHER_PHASES);
+    const unsigned expected = MIN(256, LEVELS * 16 * DITHER_PHASES + 1);
+    printf("shades per channel: %u with one phase, %u with both (%u expected)\n", shades, temporal_shades, expected);
+    if (shades != MIN(256, LEVELS * 16 + 1) || temporal_shades != expected)
+    {
+        return 1;
+    }
+
+    // The first call builds the tables, out of the measure.
+    dither_image(pixels, stride, rgb, width * 3, width, height, 0);
+
+    const double start = now_s();
+    for (unsigned i = 0; i < pictures; i++)
+    {
+        dither_image(pixels, stride, rgb, width * 3, width, height, i % DITHER_PHASES);
+    }
+    const double seconds = now_s() - start;
+
+    const double pixel_count = (double)pictures * width * height;
+    printf("%ux%u, %u bit%s: %.1f Mpixel/s, %.3f ms per picture\n", width, height, VIDEO_COLOR_BITS,
+           VIDEO_DENSE_PIXELS ? " dense" : "", pixel_count / seconds / 1e6, seconds * 1e3 / (pictures ? pictures : 1));
+
+    if (png_path)
+    {
+        const unsigned phases = temporal ? DITHER_PHASES : 1;
+        for (unsigned phase = 0; phase < phases; phase++)
+        {
+            dither_image(pixels, stride, rgb, width * 3, width, height, phase);
+            accumulate(sum, pixels, stride, width, height);
+        }
+        for (size_t i = 0; i < (size_t)width * height * 3; i++)
+        {
+            rgb[i] = sum[i] / phases;
+        }
+        if (!png_write_rgb(png_path, rgb, width, height))
+        {
+            fprintf(stderr, "%s: can't write\n", png_path);
+            return 1;
+        }
+    }
+
+    free(sum);
+    free(pixels);
+    free(rgb);
+    return 0;
+}
@@ -0,0 +1,260 @@
+/**
+ * Measure draw.c on the host against the naive loop, a pixel at a time with a branch on its place
+ * in the byte and a read-modify-write, in pixels per second.
+ *
+ * Usage: draw_bench [-n <screens>]
+ *
+ * Each shape is drawn over and over until n screens of pixels are done (650 by default).
+ * Both draw the same shapes at the same odd places into a 320x240 surface of the framebuffer format
+ * of the build (draw_bench, draw_bench_dense, draw_bench_15bit), and the two surfaces have to come
+ * out the same, exits with 1 if they don't. A vertical line is a pixel per row either way, it is only
+ * checked, without a speed-up.
+ */
+#include "draw.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WIDTH 320
+#define HEIGHT 240
+#define STRIDE DRAW_ROW_BYTES(WIDTH)
+
+static uint8_t s_fast[STRIDE * HEIGHT] __attribute__((aligned(4)));
+static uint8_t s_naive[STRIDE * HEIGHT] __attribute__((aligned(4)));
+static uint8_t s_source[STRIDE * HEIGHT] __attribute__((aligned(4)));
+
+static const struct surface_t s_fast_surface = {s_fast, WIDTH, HEIGHT, STRIDE};
+static const struct surface_t s_naive_surface = {s_naive, WIDTH, HEIGHT, STRIDE};
+static const struct surface_t s_source_surface = {s_source, WIDTH, HEIGHT, STRIDE};
+
+static unsigned get_pixel(const struct surface_t* surface, int x, int y)
+{
+    const uint8_t* row = surface->pixels + y * surface->stride;
+#if VIDEO_COLOR_BITS > 1
+    return ((const uint16_t*)row)[x];
+#elif VIDEO_DENSE_PIXELS
+    return (((const uint32_t*)row)[x / 10] >> ((x % 10) * 3)) & 7;
+#else
+    if (x & 1)
+    {
+        return (row[x >> 1] >> 3) & 7;
+    }
+    return row[x >> 1] & 7;
+#endif
+}
+
+static void set_pixel(const struct surface_t* surface, int x, int y, unsigned color)
+{
+    uint8_t* row = surface->pixels + y * surface->stride;
+#if VIDEO_COLOR_BITS > 1
+    ((uint16_t*)row)[x] = color;
+#elif VIDEO_DENSE_PIXELS
+    uint32_t* word = (uint32_t*)row + x / 10;
+    *word = (*word & ~(7u << ((x % 10) * 3))) | (color << ((x % 10) * 3));
+#else
+    if (x & 1)
+    {
+        row[x >> 1] = (row[x >> 1] & 0x07) | (color << 3);
+    }
+    else
+    {
+        row[x >> 1] = (row[x >> 1] & 0x38) | color;
+    }
+#endif
+}
+
+// The naive versions, already clipped.
+static void naive_fill_rect(const struct surface_t* surface, int x, int y, int width, int height, uint16_t color)
+{
+    for (int j = y; j < y + height; j++)
+    {
+        for (int i = x; i < x + width; i++)
+        {
+            set_pixel(surface, i, j, color);
+        }
+    }
+}
+
+static void naive_blit(const struct surface_t* surface, int x, int y, const struct surface_t* source, int src_x, int src_y, int width,
+                       int height)
+{
+    for (int j = 0; j < height; j++)
+    {
+        for (int i = 0; i < width; i++)
+        {
+            set_pixel(surface, x + i, y + j, get_pixel(source, src_x + i, src_y + j));
+        }
+    }
+}
+
+// A shape: draw.c and naive calls of the same pixels, at the i-th place.
+struct shape_t
+{
+    const char* name;
+    unsigned pixels;
+    void (*fast)(unsigned i);
+    void (*naive)(unsigned i);
+    bool spans; // draw.c writes more than a pixel at a time, the speed-up means something.
+};
+
+static uint16_t color_of(unsigned i)
+{
+    return VIDEO_COLOR_BITS > 1 ? (uint16_t)(i * 0x1234u) & ((1u << VIDEO_RGB_PINS) - 1) : i & 7;
+}
+
+static void fast_clear(unsigned i)
+{
+    draw_clear(&s_fast_surface, color_of(i));
+}
+
+static void naive_clear(unsigned i)
+{
+    naive_fill_rect(&s_naive_surface, 0, 0, WIDTH, HEIGHT, color_of(i));
+}
+
+// A surface of an odd width in the same buffer, the last column of the buffer stays as it is.
+static void fast_clear_odd(unsigned i)
+{
+    const struct surface_t surface = {s_fast, WIDTH - 1, HEIGHT, STRIDE};
+    draw_clear(&surface, color_of(i));
+}
+
+static void naive_clear_odd(unsigned i)
+{
+    naive_fill_rect(&s_naive_surface, 0, 0, WIDTH - 1, HEIGHT, color_of(i));
+}
+
+static void fast_rect(unsigned i)
+{
+    draw_fill_rect(&s_fast_surface, 1 + i % 251, i % 173, 61, 47, color_of(i));
+}
+
+static void naive_rect(unsigned i)
+{
+    naive_fill_rect(&s_naive_surface, 1 + i % 251, i % 173, 61, 47, color_of(i));
+}
+
+static void fast_hline(unsigned i)
+{
+    draw_hline(&s_fast_surface, 1 + i % 97, i % HEIGHT, 201, color_of(i));
+}
+
+static void naive_hline(unsigned i)
+{
+    naive_fill_rect(&s_naive_surface, 1 + i % 97, i % HEIGHT, 201, 1, color_of(i));
+}
+
+static void fast_vline(unsigned i)
+{
+    draw_vline(&s_fast_surface, 1 + i * 37 % 317, i % 39, 201, color_of(i));
+}
+
+static void naive_vline(unsigned i)
+{
+    naive_fill_rect(&s_naive_surface, 1 + i * 37 % 317, i % 39, 1, 201, color_of(i));
+}
+
+// Source and destination on the same place in the byte / word (both odd, x % 10 the same), and not.
+static void fast_blit(unsigned i)
+{
+    draw_blit(&s_fast_surface, 11 + 10 * (i % 24), i % 151, &s_source_surface, 11, 7, 64, 64);
+}
+
+static void naive_blit_aligned(unsigned i)
+{
+    naive_blit(&s_naive_surface, 11 + 10 * (i % 24), i % 151, &s_source_surface, 11, 7, 64, 64);
+}
+
+static void fast_blit_shifted(unsigned i)
+{
+    draw_blit(&s_fast_surface, 4 + 10 * (i % 24), i % 151, &s_source_surface, 11, 7, 64, 64);
+}
+
+static void naive_blit_shifted(unsigned i)
+{
+    naive_blit(&s_naive_surface, 4 + 10 * (i % 24), i % 151, &s_source_surface, 11, 7, 64, 64);
+}
+
+static const struct shape_t s_shapes[] = {
+    {"clear 320x240", WIDTH * HEIGHT, fast_clear, naive_clear, true},
+    {"clear 319x240", (WIDTH - 1) * HEIGHT, fast_clear_odd, naive_clear_odd, true},
+    {"fill rect 61x47", 61 * 47, fast_rect, naive_rect, true},
+    {"hline 201", 201, fast_hline, naive_hline, true},
+    {"vline 201", 201, fast_vline, naive_vline, false},
+    {"blit 64x64", 64 * 64, fast_blit, naive_blit_aligned, true},
+    {"blit 64x64 shifted", 64 * 64, fast_blit_shifted, naive_blit_shifted, true},
+};
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Mpixel/s of calls repeats times.
+static double measure(void (*call)(unsigned i), unsigned pixels, unsigned repeats)
+{
+    const double start = now_s();
+    for (unsigned i = 0; i < repeats; i++)
+    {
+        call(i);
+    }
+    return (double)pixels * repeats / (now_s() - start) / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned pixels = 650 * WIDTH * HEIGHT; // Per shape and side.
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            pixels = (unsigned)atoi(argv[++i]) * WIDTH * HEIGHT;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n <screens>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (unsigned y = 0; y < HEIGHT; y++)
+    {
+        for (unsigned x = 0; x < WIDTH; x++)
+        {
+            set_pixel(&s_source_surface, x, y, color_of(x * 7 + y));
+        }
+    }
+
+    printf("%u bit%s, Mpixel/s:\n", VIDEO_COLOR_BITS, VIDEO_DENSE_PIXELS ? " dense" : "");
+    printf("%-20s %10s %10s %8s\n", "", "draw.c", "naive", "speed-up");
+    int result = 0;
+    for (unsigned s = 0; s < sizeof(s_shapes) / sizeof(s_shapes[0]); s++)
+    {
+        const struct shape_t* shape = &s_shapes[s];
+        const unsigned repeats = pixels / shape->pixels + 1;
+
+        memset(s_fast, 0, sizeof(s_fast));
+        memset(s_naive, 0, sizeof(s_naive));
+        const double fast = measure(shape->fast, shape->pixels, repeats);
+        const double naive = measure(shape->naive, shape->pixels, repeats);
+        const bool same = memcmp(s_fast, s_naive, sizeof(s_fast)) == 0;
+        if (shape->spans)
+        {
+            printf("%-20s %10.0f %10.0f %7.1fx%s\n", shape->name, fast, naive, fast / naive, same ? "" : "  DIFFERENT PIXELS");
+        }
+        else
+        {
+            printf("%-20s %10s %10s %8s%s\n", shape->name, "", "", "-", same ? "" : "  DIFFERENT PIXELS");
+        }
+        if (!same)
+        {
+            result = 1;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,227 @@
+/**
+ * Host check of framebuffer.c: its display lists, built by display_list.c on tools/sdk_stub, go
+ * through the DMA chain model of pio_sim while the application draws pictures and flips at random
+ * times, half of them around the end of a field, and scrolls. Every field sent must be a single
+ * picture, all of them shown in order, each line the ring row of the scroll framebuffer_get_line()
+ * goes by and the borders around them.
+ *
+ * Each word of a picture holds its number and its ring row, the border a word of its own. Built
+ * once per configuration (see CMakeLists.txt), exits with 1 at the first wrong word.
+ *
+ *   framebuffer_check [seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dma_model.h"
+#include "framebuffer.h"
+#include "sdk_stub.h"
+
+#define PICTURES 100
+#define LINE_WORDS (LINE_COUNT / 4)
+#define BORDER_TOP_LINES 42 // PAL.
+#define BORDER_WORD 0x0000beefu
+#define PIXEL_WORD(picture, row) (0x80000000u | (uint32_t)(picture) << 12 | (row))
+
+// The rgb state machine takes a word every 3 cycles per pixel out of its FIFO.
+#define FIFO_WORDS 4
+#define WORD_CYCLES (VIDEO_PIXELS_PER_WORD * 3)
+
+static const struct sync_field_t* const s_fields = VIDEO_INTERLACED ? sync_pal_interlaced : sync_pal_progressive;
+static const uint32_t s_border = BORDER_WORD;
+
+static struct dma_model_t s_dma;
+static uint64_t s_cycles = 0;
+static uint s_fifo = 0;
+
+// Field being received: its list, its words so far, its picture (-1 before the first pixel) and the ring row
+// on its first line.
+static uint64_t s_list = 0;
+static uint s_field = 0;
+static uint s_words = 0;
+static int s_picture = -1;
+static uint s_scroll = 0;
+
+// Picture of the last field received, and fields checked.
+static int s_shown = -1;
+static uint s_field_count = 0;
+
+void video_add_border_top(struct display_list_t* list)
+{
+    display_list_add_border(list, &s_border, BORDER_TOP_LINES);
+}
+
+void video_add_border_bottom(struct display_list_t* list, uint field)
+{
+    display_list_add_border(list, &s_border, s_fields[field].lines - BORDER_TOP_LINES - RES_Y);
+}
+
+void video_set_list_builder(void (*build)(void))
+{
+    (void)build;
+}
+
+static void fail(const char* what, uint32_t word, uint32_t expected)
+{
+    printf("FAIL: field %u (%u), line %u, word %u: %s, %08x instead of %08x\n", s_field_count, s_field, s_words / LINE_WORDS,
+           s_words % LINE_WORDS, what, word, expected);
+    exit(1);
+}
+
+static void end_field(void)
+{
+    const uint32_t words = s_fields[s_field].lines * LINE_WORDS;
+    if (s_words != words)
+    {
+        fail("field length", s_words, words);
+    }
+    // The same picture or the next one, none is skipped.
+    if (s_picture != s_shown && s_picture != s_shown + 1)
+    {
+        fail("picture out of order", s_picture, s_shown + 1);
+    }
+    s_shown = s_picture;
+    s_field_count++;
+}
+
+static bool rgb_dreq(void* context)
+{
+    (void)context;
+    return s_fifo < FIFO_WORDS;
+}
+
+static void rgb_write(void* context, uint32_t word)
+{
+    (void)context;
+    s_fifo++;
+
+    // Channel 2 restarted channel 1 since the last word: a new field.
+    if (s_dma.lists != s_list)
+    {
+        if (s_list)
+        {
+            end_field();
+        }
+        s_list = s_dma.lists;
+        s_field = (uint)((s_list - 1) % VIDEO_FIELDS);
+        s_words = 0;
+        s_picture = -1;
+    }
+
+    const uint line = s_words / LINE_WORDS;
+    uint32_t expected = BORDER_WORD;
+    if (line >= BORDER_TOP_LINES && line < BORDER_TOP_LINES + RES_Y)
+    {
+        // The frame handler has run by the first pixel, the scroll of the field is settled.
+        if (s_picture < 0)
+        {
+            uint8_t* front = framebuffer_get_front();
+            s_picture = (int)((word >> 12) & 0x7ffff);
+            s_scroll = (uint)(framebuffer_get_line(front, 0) - front) / LINE_COUNT;
+        }
+        const uint row = ((line - BORDER_TOP_LINES) * VIDEO_FIELDS + s_field) / VIDEO_LINE_REPEAT;
+        expected = PIXEL_WORD(s_picture, (s_scroll + row) % FRAMEBUFFER_LINES);
+    }
+    if (word != expected)
+    {
+        fail("wrong word", word, expected);
+    }
+    s_words++;
+}
+
+static void step(void)
+{
+    dma_model_step(&s_dma);
+    if (++s_cycles % WORD_CYCLES == 0 && s_fifo)
+    {
+        s_fifo--;
+    }
+}
+
+static void run(uint cycles)
+{
+    while (cycles--)
+    {
+        step();
+    }
+}
+
+// Every ring row of the buffer, a few cycles per word so the fields go by meanwhile, scrolling now and then.
+static void draw(uint8_t* framebuffer, uint picture)
+{
+    for (uint row = 0; row < FRAMEBUFFER_LINES; row++)
+    {
+        uint32_t* words = (uint32_t*)(framebuffer + row * LINE_COUNT);
+        for (uint i = 0; i < LINE_WORDS; i++)
+        {
+            words[i] = PIXEL_WORD(picture, row);
+            run(rand() % 64);
+            if (rand() % 1024 == 0)
+            {
+                framebuffer_set_scroll(rand());
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    srand(argc > 1 ? (unsigned)atoi(argv[1]) : 1);
+    const uint field_cycles = s_fields[0].lines * LINE_WORDS * WORD_CYCLES;
+
+    display_list_init(pio0, 1, LINE_COUNT);
+    framebuffer_init();
+    for (uint row = 0; row < FRAMEBUFFER_LINES; row++)
+    {
+        uint32_t* words = (uint32_t*)(framebuffer_get_front() + row * LINE_COUNT);
+        for (uint i = 0; i < LINE_WORDS; i++)
+        {
+            words[i] = PIXEL_WORD(0, row);
+        }
+    }
+
+    // framebuffer_wait_flip() and the others wait on the model.
+    sdk_stub_set_idle(step);
+    dma_model_init(&s_dma, rgb_dreq, rgb_write, NULL);
+    display_list_start();
+
+    for (uint picture = 1; picture <= PICTURES; picture++)
+    {
+        // Double buffered the back buffer is the front one until the flip is applied.
+        if (FRAMEBUFFER_COUNT == 2)
+        {
+            framebuffer_wait_flip();
+        }
+        draw(framebuffer_get_back(), picture);
+
+        // Every other flip lands around the end of a field: before channel 2 restarts channel 1, between that and the
+        // frame handler, or right after the handler.
+        if (rand() & 1)
+        {
+            while (s_words + 2 < s_fields[s_field].lines * LINE_WORDS)
+            {
+                step();
+            }
+            run(rand() % (2 * WORD_CYCLES + 2 * DMA_MODEL_IRQ_CYCLES));
+            framebuffer_set_scroll(rand());
+        }
+        framebuffer_flip();
+        run(rand() % (2 * field_cycles));
+    }
+
+    // Until the last picture has been sent whole.
+    framebuffer_wait_flip();
+    const uint64_t list = s_dma.lists;
+    while (s_dma.lists < list + 2 * VIDEO_FIELDS)
+    {
+        step();
+    }
+    if (s_shown != PICTURES)
+    {
+        fail("last picture", s_shown, PICTURES);
+    }
+
+    printf("ok: %u fields, %u pictures, %u framebuffers, %u fields per frame, rows repeated %u times\n", s_field_count, PICTURES,
+           FRAMEBUFFER_COUNT, VIDEO_FIELDS, VIDEO_LINE_REPEAT);
+    return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * Display list DMA chain model, see dma_model.h.
+ */
+#include "dma_model.h"
+
+#include "sdk_stub.h"
+
+// Channel whose register the address is, -1 if it is none of them.
+static int channel_of(uintptr_t write_addr, size_t register_offset)
+{
+    for (int channel = 0; channel < NUM_DMA_CHANNELS; channel++)
+    {
+        if (write_addr == (uintptr_t)&dma_hw->ch[channel] + register_offset)
+        {
+            return channel;
+        }
+    }
+    return -1;
+}
+
+static void trigger(struct dma_model_t* dma, int channel)
+{
+    dma_start_channel_mask(1u << channel);
+    dma->reload = DMA_MODEL_RELOAD_CYCLES;
+}
+
+static void finish(struct dma_model_t* dma, uint channel)
+{
+    dma_channel_hw_t* hw = &dma_hw->ch[channel];
+    hw->al1_ctrl &= ~DMA_CH0_CTRL_TRIG_BUSY_BITS;
+
+    if (!(hw->al1_ctrl & DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS))
+    {
+        dma_hw->ints0 |= 1u << channel;
+        if (dma_hw->inte0 & (1u << channel))
+        {
+            dma->irq = DMA_MODEL_IRQ_CYCLES;
+        }
+    }
+
+    const uint chain_to = (hw->al1_ctrl & DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS) >> DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB;
+    if (chain_to != channel)
+    {
+        trigger(dma, chain_to);
+    }
+}
+
+// Channel 1: the control block goes into the CTRL, read, write and count registers of the target, the
+// count is the trigger.
+static void load_block(struct dma_model_t* dma, uint channel, int target)
+{
+    dma_channel_hw_t* hw = &dma_hw->ch[channel];
+    const struct control_block_t* block = (const struct control_block_t*)hw->read_addr;
+    dma_channel_hw_t* target_hw = &dma_hw->ch[target];
+    target_hw->al1_ctrl = block->ctrl;
+    target_hw->read_addr = (uintptr_t)block->read_addr;
+    target_hw->write_addr = (uintptr_t)block->write_addr;
+    target_hw->transfer_count = block->count;
+    hw->read_addr += sizeof(*block);
+
+    finish(dma, channel);
+    trigger(dma, target);
+}
+
+// Channel 2: the address read goes into the read address trigger of the target. A read ring of 2^n bytes
+// holds 2^n / 4 addresses on the chip.
+static void restart(struct dma_model_t* dma, uint channel, int target)
+{
+    dma_channel_hw_t* hw = &dma_hw->ch[channel];
+    dma_hw->ch[target].read_addr = *(const uintptr_t*)hw->read_addr;
+    hw->read_addr += sizeof(uintptr_t);
+
+    const uint ring_bits = (hw->al1_ctrl & DMA_CH0_CTRL_TRIG_RING_SIZE_BITS) >> DMA_CH0_CTRL_TRIG_RING_SIZE_LSB;
+    if (ring_bits && !(hw->al1_ctrl & DMA_CH0_CTRL_TRIG_RING_SEL_BITS) &&
+        hw->read_addr - hw->ring_start == ((1u << ring_bits) / 4) * sizeof(uintptr_t))
+    {
+        hw->read_addr = hw->ring_start;
+    }
+    dma->lists++;
+
+    finish(dma, channel);
+    trigger(dma, target);
+}
+
+// Channel 0: one word into the FIFO.
+static void transfer(struct dma_model_t* dma, uint channel)
+{
+    if (!dma->dreq(dma->context))
+    {
+        return;
+    }
+
+    dma_channel_hw_t* hw = &dma_hw->ch[channel];
+    dma->write(dma->context, *(const uint32_t*)hw->read_addr);
+    dma->transfers++;
+    if (hw->al1_ctrl & DMA_CH0_CTRL_TRIG_INCR_READ_BITS)
+    {
+        hw->read_addr += 4;
+    }
+    if (--hw->transfer_count == 0)
+    {
+        finish(dma, channel);
+    }
+}
+
+void dma_model_init(struct dma_model_t* dma, bool (*dreq)(void* context), void (*write)(void* context, uint32_t word), void* context)
+{
+    dma->dreq = dreq;
+    dma->write = write;
+    dma->context = context;
+    dma->reload = DMA_MODEL_RELOAD_CYCLES;
+    dma->irq = 0;
+    dma->transfers = 0;
+    dma->lists = 0;
+}
+
+void dma_model_step(struct dma_model_t* dma)
+{
+    // ints0 is write 1 to clear on the chip, the handler acknowledged it once it ran.
+    if (dma->irq && --dma->irq == 0)
+    {
+        sdk_stub_irq(DMA_IRQ_0);
+        dma_hw->ints0 = 0;
+    }
+
+    if (dma->reload)
+    {
+        dma->reload--;
+        return;
+    }
+
+    // The channels of the chain take turns, one of them at most is busy.
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++)
+    {
+        const dma_channel_hw_t* hw = &dma_hw->ch[channel];
+        if (!(hw->al1_ctrl & DMA_CH0_CTRL_TRIG_BUSY_BITS))
+        {
+            continue;
+        }
+
+        const int block_target = channel_of(hw->write_addr, offsetof(dma_channel_hw_t, al1_ctrl));
+        const int restart_target = channel_of(hw->write_addr, offsetof(dma_channel_hw_t, al3_read_addr_trig));
+        if (block_target >= 0)
+        {
+            load_block(dma, channel, block_target);
+        }
+        else if (restart_target >= 0)
+        {
+            restart(dma, channel, restart_target);
+        }
+        else
+        {
+            transfer(dma, channel);
+        }
+        return;
+    }
+}
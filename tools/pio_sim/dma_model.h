@@ -0,0 +1,43 @@
+/**
+ * Model of the display list DMA chain of display_list.c, run on the channel registers of the
+ * host SDK (tools/sdk_stub) so the very lists the firmware builds are sent.
+ *
+ * A channel does what its write address says: into the CTRL of another channel it copies a
+ * control block there and triggers it (channel 1), into the read address trigger of another
+ * channel it restarts that one with the address it reads, stepping through its read ring
+ * (channel 2), anything else is a FIFO it writes one 32-bit word per system clock into while
+ * the DREQ allows it (channel 0). A finished channel triggers the one it chains to and raises
+ * its interrupt unless it is quiet, the handler of DMA_IRQ_0 runs a little later, like on the
+ * chip once channel 2 has restarted channel 1. Each trigger takes a few cycles.
+ */
+#ifndef DMA_MODEL_H
+#define DMA_MODEL_H
+
+#include "display_list.h"
+
+// Cycles from the end of a channel to the first transfer of the one it triggers, and from the end of the
+// last block of a list to its irq handler.
+#define DMA_MODEL_RELOAD_CYCLES 5
+#define DMA_MODEL_IRQ_CYCLES 40
+
+struct dma_model_t
+{
+    // The FIFO channel 0 writes to: dreq() says if there is room, write() takes the word.
+    bool (*dreq)(void* context);
+    void (*write)(void* context, uint32_t word);
+    void* context;
+
+    unsigned reload; // Cycles left before a channel runs again.
+    unsigned irq;	 // Cycles left before the handler of DMA_IRQ_0 runs, 0 for none pending.
+
+    // Statistics.
+    uint64_t transfers;
+    uint64_t lists; // Times channel 2 started a list.
+};
+
+void dma_model_init(struct dma_model_t* dma, bool (*dreq)(void* context), void (*write)(void* context, uint32_t word), void* context);
+
+// Run one system clock cycle, display_list_start() started the chain.
+void dma_model_step(struct dma_model_t* dma);
+
+#endif
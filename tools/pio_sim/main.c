@@ -0,0 +1,793 @@
+/**
+ * Run csync.pio and rgb.pio the way video_init() and video_start() set them up and write the
+ * pin changes, so pulse widths and line periods can be checked without a scope or a TV.
+ *
+ * Usage: pio_sim [-d <dir with the .pio files>] [-t <microseconds>] [-o <trace file>]
+ *                [--vcd <file>] [--png <file>] [--fb <raw framebuffer>] [--interlaced] [--mode <name>] [--ntsc]
+ *                [--res-x <pixels>] [--dense] [--color-bits <1-5>] [--hscroll <pixels>] [--line-repeat <n>]
+ *                [--restart <microseconds>] [--check]
+ *
+ * The csync state machine is fed the sync table of sync.c, like the sync DMA of video.c does.
+ * The rgb state machine is fed by the display lists of display_list.c, run by a model of its DMA
+ * chain (dma_model.h), sending a framebuffer the way framebuffer.c does: top border, RES_Y lines,
+ * bottom border. The framebuffer is a
+ * test pattern, or the raw packed pixels of --fb (RES_Y lines of LINE_COUNT bytes, twice as
+ * many with --interlaced, where each field gets every other line). --mode picks one of the modes
+ * of video_mode.c (pal, pal_wide, ntsc, ntsc_wide), --ntsc is short for --mode ntsc. --res-x is RES_X,
+ * 320 by default, the pixel clock of the mode follows it like in the firmware. --dense is
+ * VIDEO_DENSE_PIXELS: rgb_dense and 10 pixels per word in the framebuffer. --color-bits is
+ * VIDEO_COLOR_BITS: above 1 rgb_wide drives 3 * bits pins from GPIO 0 with halfword pixels.
+ * --hscroll runs the scroll program of video_set_hscroll() instead, sending the lines the way
+ * raster.c does: a scroll word and LINE_COUNT + 4 bytes, the test pattern twice as wide and
+ * scrolled by that many pixels, borders a word per line. --line-repeat is VIDEO_LINE_REPEAT: the
+ * framebuffer (and --fb) has that many times fewer rows and each one is sent on as many lines.
+ * --restart runs video_stop() and video_start() at that time, wherever the state machines and the
+ * lists are, and the outputs go on from there.
+ *
+ * Outputs, by default one field:
+ *  -o: one line per pin change, "<time in ns> <gpio> <level>", stdout if no other output is asked.
+ *  --vcd: waveform of csync, the rgb pins, irq 0 and the display list block, for GTKWave.
+ *  --png: the picture a TV would show of the first field, or frame with --interlaced, see tv_decode.h.
+ *
+ * With --check nothing is written, instead CHECK_FIELDS (3) fields are simulated from the start, or
+ * from the restart, and checked: the sync pulses against PAL or NTSC, widened to the allowance the
+ * mode states for each of its deliberate deviations (s_allowances), the periods against the sync
+ * table, and the pixels centred in the active line of the standard (see timing_check.h). The exit code is 1 if anything is out of tolerance or fewer fields were measured,
+ * so it can gate a build. The pixels go through the same display lists and DMA model as the other
+ * outputs, with a white border and a pattern without black so every line shows its first and last
+ * pixel: a list that sends a line short or late fails. With --hscroll every line skips a different
+ * number of pixels in turn, or is a line of one colour. Which pixels the lines show is checked by
+ * tools/framebuffer_check.
+ */
+#include "clock_plan.h"
+#include "display_list.h"
+#include "dma_model.h"
+#include "pio_sim.h"
+#include "png.h"
+#include "sdk_stub.h"
+#include "sync.h"
+#include "timing_check.h"
+#include "tv_decode.h"
+#include "vcd.h"
+#include "video_mode.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Same values as the firmware, see video.h.
+#define SYS_CLOCK_MIN_HZ 100000000
+#define SYS_CLOCK_MAX_HZ 133000000
+#define CLOCK_PPM 10
+#define MAX_RES_X 720
+#define RES_Y 240
+#define PIXELS_PER_WORD (s_color_bits > 1 ? 2 : s_dense ? 10 : 8)
+#define MAX_PIXELS_PER_WORD 10
+#define LINE_WORDS (s_res_x / PIXELS_PER_WORD)
+#define LINE_COUNT (LINE_WORDS * 4)
+#define MAX_FRAME_Y (RES_Y * 2)
+#define CSYNC_PIN 16
+#define RED_PIN 18
+#define WIDE_RED_PIN 0 // Multi-bit colour, see video.h.
+#define CSYNC_SM 0
+#define RGB_SM 1
+#define CHECK_FIELDS 3 // Measured by --check.
+
+static unsigned s_res_x = 320;
+static bool s_dense = false; // VIDEO_DENSE_PIXELS: 10 pixels per word and rgb_dense.
+static unsigned s_color_bits = 1; // VIDEO_COLOR_BITS: above 1 rgb_wide, halfword pixels on 3 * s_color_bits pins.
+static unsigned s_rgb_pin = RED_PIN;
+static int s_hscroll = -1; // Pixels, the scroll program if not negative.
+static unsigned s_line_repeat = 1; // VIDEO_LINE_REPEAT: lines showing each framebuffer row.
+
+#define RGB_PINS (3 * s_color_bits)
+#define RGB_MASK ((1u << RGB_PINS) - 1)
+
+// Pin code of one of the 8 colours, full scale channels.
+static uint32_t color_code(unsigned color)
+{
+    const uint32_t channel = (1u << s_color_bits) - 1;
+    return ((color & 1) ? channel : 0) | ((color & 2) ? channel << s_color_bits : 0) | ((color & 4) ? channel << (2 * s_color_bits) : 0);
+}
+
+// A 32-bit word of pixels of one of the 8 colours, VIDEO_COLOR_WORD() of the format.
+static uint32_t color_word(unsigned color)
+{
+    if (s_color_bits > 1)
+    {
+        return color_code(color) * 0x00010001u;
+    }
+    return s_dense ? color * 0x09249249u : (color | (color << 3)) * 0x01010101u;
+}
+
+static unsigned symbol(const struct pio_program_t* program, const char* name)
+{
+    int value = 0;
+    if (!pio_asm_find_symbol(program, name, &value))
+    {
+        fprintf(stderr, "%s: no label %s\n", program->name, name);
+        exit(1);
+    }
+    return (unsigned)value;
+}
+
+// The labels video.c gives video_mode_scroll_word() and video_mode_color_line_word().
+static struct video_scroll_program_t scroll_program(const struct pio_program_t* program, unsigned offset)
+{
+    struct video_scroll_program_t labels = {0};
+    labels.wide = s_color_bits > 1;
+    labels.odd = offset + symbol(program, labels.wide ? "odd" : "odd_drop");
+    labels.even = offset + symbol(program, labels.wide ? "even" : "even_drop");
+    labels.drain = offset + symbol(program, "drain");
+    labels.line = labels.wide ? 0 : offset + symbol(program, "line");
+    labels.blank = offset + symbol(program, "blank");
+    return labels;
+}
+
+static bool load_program(struct pio_sim_t* sim, const char* dir, const char* file, const char* name, struct pio_source_t* source,
+                         const struct pio_program_t** program, int* offset)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.pio", dir, file);
+    if (!pio_asm_file(path, source))
+    {
+        return false;
+    }
+
+    *program = pio_asm_find_program(source, name);
+    if (!*program)
+    {
+        fprintf(stderr, "%s: no .program %s\n", path, name);
+        return false;
+    }
+
+    *offset = pio_sim_add_program(sim, *program);
+    if (*offset < 0)
+    {
+        fprintf(stderr, "%s: doesn't fit in the instruction memory\n", path);
+        return false;
+    }
+    return true;
+}
+
+// csync_program_init() of csync.pio.
+static void csync_init(struct pio_sim_t* sim, const struct pio_program_t* program, int offset, const struct clock_plan_t* plan)
+{
+    struct pio_sim_config_t config = pio_sim_get_default_config(program, offset);
+    config.set_base = CSYNC_PIN;
+    config.set_count = 1;
+    config.out_shift_right = true;
+    config.autopull = true;
+    config.pull_threshold = 16;
+    config.join_tx = true;
+    config.clkdiv_int = plan->csync_div_int;
+    config.clkdiv_frac = plan->csync_div_frac;
+    sim->pindirs |= 1u << CSYNC_PIN;
+    pio_sim_sm_init(sim, CSYNC_SM, offset, &config);
+}
+
+// rgb_program_init() of rgb.pio.
+static void rgb_init(struct pio_sim_t* sim, const struct pio_program_t* program, int offset, const struct clock_plan_t* plan)
+{
+    struct pio_sim_config_t config = pio_sim_get_default_config(program, offset);
+    config.set_base = s_rgb_pin;
+    config.set_count = RGB_PINS < 5 ? RGB_PINS : 5;
+    config.out_base = s_rgb_pin;
+    config.out_count = RGB_PINS;
+    config.out_shift_right = true;
+    config.autopull = true;
+    config.pull_threshold = 32;
+    config.clkdiv_int = plan->rgb_div_int;
+    config.clkdiv_frac = plan->rgb_div_frac;
+    config.join_tx = true;
+    sim->pindirs |= RGB_MASK << s_rgb_pin;
+    pio_sim_sm_init(sim, RGB_SM, offset, &config);
+}
+
+// The pulses of the modes deliberately off the standard, see timing_check.h: --check accepts them up to these bounds
+// and fails beyond. 5 us hsync, 30 us broad and 2 us equalising pulses at 1 us tics, 4.97, 26.81 and 1.99 us at
+// the tics of NTSC, a hundredth of a microsecond of fractional divider on top.
+static const struct timing_allowance_t s_pal_hsync = {4.5, 5.01};
+static const struct timing_allowance_t s_pal_broad = {27.2, 30.01};
+static const struct timing_allowance_t s_pal_equalising = {1.99, 2.45};
+static const struct timing_allowance_t s_ntsc_hsync = {4.6, 4.98};
+static const struct timing_allowance_t s_ntsc_broad = {26.80, 27.2};
+static const struct timing_allowance_t s_ntsc_equalising = {1.97, 2.4};
+
+static const struct
+{
+    const struct video_mode_t* mode;
+    const struct timing_allowance_t* hsync;
+    const struct timing_allowance_t* broad;
+    const struct timing_allowance_t* equalising;
+} s_allowances[] = {
+    {&video_mode_pal, &s_pal_hsync, &s_pal_broad, &s_pal_equalising},
+    {&video_mode_pal_wide, &s_pal_hsync, &s_pal_broad, &s_pal_equalising},
+    {&video_mode_ntsc, &s_ntsc_hsync, &s_ntsc_broad, &s_ntsc_equalising},
+    {&video_mode_ntsc_wide, &s_ntsc_hsync, &s_ntsc_broad, &s_ntsc_equalising},
+};
+
+// video_start(): both state machines from the top of their programs with empty FIFOs, csync high, the pixels black
+// and no irq left, the loops of the programs that take them from the FIFO, then enabled together.
+static void start(struct pio_sim_t* sim, const struct pio_program_t* csync, int csync_offset, const struct pio_program_t* rgb,
+                  int rgb_offset, const struct clock_plan_t* plan)
+{
+    csync_init(sim, csync, csync_offset, plan);
+    rgb_init(sim, rgb, rgb_offset, plan);
+    sim->pins = (sim->pins | (1u << CSYNC_PIN)) & ~(RGB_MASK << s_rgb_pin);
+    sim->irq = 0;
+    if (s_hscroll < 0)
+    {
+        pio_sim_put(sim, RGB_SM, (s_dense || s_color_bits > 1 ? LINE_WORDS : LINE_COUNT) - 1);
+    }
+    pio_sim_enable_sm_mask_in_sync(sim, (1u << CSYNC_SM) | (1u << RGB_SM));
+}
+
+// Colour bars of 40 pixels with a white frame on the outermost pixels, a lost pixel at any edge shows. Without
+// black with --check, where the first and the last pixel of a line have to show on the pins.
+static void draw_test_pattern(uint8_t* framebuffer, unsigned width, unsigned height, unsigned stride, bool no_black)
+{
+    for (unsigned y = 0; y < height; y++)
+    {
+        for (unsigned x = 0; x < width; x++)
+        {
+            const bool frame = (x == 0 || y == 0 || x == width - 1 || y == height - 1);
+            const uint8_t color = frame ? 7 : no_black ? 1 + (x / 40) % 7 : (x / 40) % 8;
+            if (s_color_bits > 1)
+            {
+                uint8_t* pixel = &framebuffer[y * stride + x * 2];
+                pixel[0] = color_code(color);
+                pixel[1] = color_code(color) >> 8;
+                continue;
+            }
+            if (s_dense)
+            {
+                uint8_t* word = &framebuffer[y * stride + x / 10 * 4];
+                const uint32_t shift = (x % 10) * 3;
+                const uint32_t value = (word[0] | (word[1] << 8) | (word[2] << 16) | ((uint32_t)word[3] << 24)) | (color << shift);
+                word[0] = value;
+                word[1] = value >> 8;
+                word[2] = value >> 16;
+                word[3] = value >> 24;
+                continue;
+            }
+            uint8_t* pixels = &framebuffer[y * stride + (x >> 1)];
+            *pixels = (x & 1) ? (*pixels & 7) | (color << 3) : (*pixels & ~7) | color;
+        }
+    }
+}
+
+static bool load_framebuffer(const char* path, uint8_t* framebuffer, unsigned height)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "%s: can't open\n", path);
+        return false;
+    }
+    const size_t size = fread(framebuffer, 1, height * LINE_COUNT, file);
+    fclose(file);
+    if (size != height * LINE_COUNT)
+    {
+        fprintf(stderr, "%s: %zu bytes, a framebuffer is %u\n", path, size, height * LINE_COUNT);
+        return false;
+    }
+    return true;
+}
+
+// Blocks of a display list: top border, two per line at most and bottom border.
+#define LIST_BLOCKS (2 * RES_Y + 2)
+
+// The display lists of framebuffer.c, built with display_list.c: per field the top border, the lines
+// of the field (a row on s_line_repeat lines) and the bottom border, which is one line longer in
+// the first field of interlaced.
+static void build_lists(struct display_list_t* lists, struct control_block_t (*blocks)[LIST_BLOCKS], const uint8_t* framebuffer,
+                        const uint32_t* border_color, const struct sync_field_t* fields, unsigned field_count,
+                        unsigned border_top_lines)
+{
+    for (unsigned field = 0; field < field_count; field++)
+    {
+        struct display_list_t* list = &lists[field];
+        display_list_begin(list, blocks[field], LIST_BLOCKS);
+        display_list_add_border(list, border_color, border_top_lines);
+        for (unsigned row = 0; row < RES_Y; row++)
+        {
+            // A block per line when interlaced or repeated, like framebuffer.c, contiguous lines merge otherwise.
+            const unsigned y = (row * field_count + field) / s_line_repeat;
+            if (field_count > 1 || s_line_repeat > 1)
+            {
+                display_list_add_line(list, &framebuffer[y * LINE_COUNT]);
+            }
+            else
+            {
+                display_list_add_lines(list, &framebuffer[y * LINE_COUNT], 1);
+            }
+        }
+        display_list_add_border(list, border_color, fields[field].lines - border_top_lines - RES_Y);
+        display_list_end(list);
+    }
+    display_list_show_fields(&lists[0], &lists[field_count - 1]);
+}
+
+// The display list of raster.c for the scroll program: every line of the pattern twice as wide, a scroll word and one
+// more word of pixels per line, borders a word per line. words[] has the scroll words of 0 to PIXELS_PER_WORD - 1
+// pixels and a colour line: the lines skip the pixels of --hscroll, or with --check each number of pixels in turn and
+// then a line of one colour.
+static void build_scroll_list(struct display_list_t* list, struct control_block_t* blocks, const uint8_t* framebuffer,
+                              const uint32_t* words, const uint32_t* border, const struct sync_field_t* fields,
+                              unsigned border_top_lines, bool every_way)
+{
+    display_list_begin(list, blocks, LIST_BLOCKS);
+    display_list_add_fill(list, border, border_top_lines);
+    for (unsigned y = 0; y < RES_Y; y++)
+    {
+        const unsigned pixels = every_way ? y % (PIXELS_PER_WORD + 1) : (unsigned)s_hscroll % PIXELS_PER_WORD;
+        if (pixels == PIXELS_PER_WORD)
+        {
+            display_list_add_fill(list, &words[pixels], 1);
+            continue;
+        }
+        display_list_add_words(list, &words[pixels], 1);
+        display_list_add_words(list, &framebuffer[y * 2 * LINE_COUNT + s_hscroll / PIXELS_PER_WORD * 4], LINE_WORDS + 1);
+    }
+    display_list_add_fill(list, border, fields[0].lines - border_top_lines - RES_Y);
+    display_list_end(list);
+    display_list_show(list);
+}
+
+// Channel 0 of the display list feeds the TX FIFO of the rgb state machine.
+static bool rgb_dreq(void* context)
+{
+    struct pio_sim_t* sim = context;
+    return pio_sim_get_tx_level(sim, RGB_SM) < sim->sm[RGB_SM].tx.depth;
+}
+
+static void rgb_write(void* context, uint32_t word)
+{
+    pio_sim_put(context, RGB_SM, word);
+}
+
+// Block of the list being sent, for the waveform.
+static unsigned active_block(const struct display_list_t* lists, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (display_list_is_active(&lists[i]))
+        {
+            return (unsigned)display_list_get_block(&lists[i]);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    const char* dir = ".";
+    const char* output = NULL;
+    const char* vcd_path = NULL;
+    const char* png_path = NULL;
+    const char* framebuffer_path = NULL;
+    double duration_us = 0;
+    double restart_us = 0; // video_stop() and video_start() then, 0 for none.
+    bool check_mode = false;
+    unsigned check_fields = 0; // Fields --check has to measure, any number with -t.
+    bool interlaced = false;
+    const struct video_mode_t* mode = &video_mode_pal;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+        {
+            dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            duration_us = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else if (strcmp(argv[i], "--vcd") == 0 && i + 1 < argc)
+        {
+            vcd_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--png") == 0 && i + 1 < argc)
+        {
+            png_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--fb") == 0 && i + 1 < argc)
+        {
+            framebuffer_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--interlaced") == 0)
+        {
+            interlaced = true;
+        }
+        else if (strcmp(argv[i], "--ntsc") == 0)
+        {
+            mode = &video_mode_ntsc;
+        }
+        else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc)
+        {
+            mode = video_mode_find(argv[++i]);
+            if (!mode)
+            {
+                fprintf(stderr, "%s: no such mode\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "--res-x") == 0 && i + 1 < argc)
+        {
+            s_res_x = (unsigned)atoi(argv[++i]);
+            if (s_res_x < 8 || s_res_x > MAX_RES_X)
+            {
+                fprintf(stderr, "%s: up to %d pixels\n", argv[i], MAX_RES_X);
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "--dense") == 0)
+        {
+            s_dense = true;
+        }
+        else if (strcmp(argv[i], "--color-bits") == 0 && i + 1 < argc)
+        {
+            s_color_bits = (unsigned)atoi(argv[++i]);
+            if (s_color_bits < 1 || s_color_bits > 5)
+            {
+                fprintf(stderr, "%s: 1 to 5 bits per channel\n", argv[i]);
+                return 2;
+            }
+            s_rgb_pin = s_color_bits > 1 ? WIDE_RED_PIN : RED_PIN;
+        }
+        else if (strcmp(argv[i], "--hscroll") == 0 && i + 1 < argc)
+        {
+            s_hscroll = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--line-repeat") == 0 && i + 1 < argc)
+        {
+            s_line_repeat = (unsigned)atoi(argv[++i]);
+            if (s_line_repeat < 1 || RES_Y % s_line_repeat)
+            {
+                fprintf(stderr, "%s: must divide %d\n", argv[i], RES_Y);
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "--restart") == 0 && i + 1 < argc)
+        {
+            restart_us = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--check") == 0)
+        {
+            check_mode = true;
+        }
+        else
+        {
+            fprintf(stderr,
+                    "usage: %s [-d <dir with the .pio files>] [-t <microseconds>] [-o <trace file>]\n"
+                    "          [--vcd <file>] [--png <file>] [--fb <raw framebuffer>] [--interlaced] [--mode <name>] [--ntsc]\n"
+                    "          [--res-x <pixels>] [--dense] [--color-bits <1-5>] [--hscroll <pixels>] [--line-repeat <n>]\n"
+                    "          [--restart <microseconds>] [--check]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (s_dense && s_color_bits > 1)
+    {
+        fprintf(stderr, "--dense is a format of 1 bit colour\n");
+        return 2;
+    }
+    if (s_res_x % PIXELS_PER_WORD)
+    {
+        fprintf(stderr, "%u: not a whole number of %u pixel words\n", s_res_x, PIXELS_PER_WORD);
+        return 2;
+    }
+
+    if (check_mode && framebuffer_path)
+    {
+        fprintf(stderr, "--check sends its own pattern, no --fb\n");
+        return 2;
+    }
+    if (s_hscroll >= 0 && (s_dense || interlaced || framebuffer_path || s_line_repeat > 1 || s_hscroll >= (int)s_res_x))
+    {
+        fprintf(stderr, "--hscroll: 0 to %u pixels, progressive, no --dense, --fb nor --line-repeat\n", s_res_x - 1);
+        return 2;
+    }
+
+    static struct pio_sim_t sim;
+    static struct pio_source_t csync_source;
+    static struct pio_source_t rgb_source;
+    const struct pio_program_t* csync;
+    const struct pio_program_t* rgb;
+    int csync_offset;
+    int rgb_offset;
+
+    pio_sim_init(&sim);
+    if (!load_program(&sim, dir, "csync", "csync", &csync_source, &csync, &csync_offset) ||
+        !load_program(&sim, dir, "rgb",
+                      s_hscroll >= 0 ? (s_color_bits > 1 ? "rgb_wide_scroll" : "rgb_scroll")
+                                     : (s_color_bits > 1 ? "rgb_wide" : s_dense ? "rgb_dense" : "rgb"),
+                      &rgb_source, &rgb, &rgb_offset))
+    {
+        return 1;
+    }
+    fprintf(stderr, "csync: %d instructions at %d, rgb: %d instructions at %d\n", csync->length, csync_offset, rgb->length, rgb_offset);
+
+    // The clocks of video_init().
+    struct clock_plan_t plan;
+    const bool clock_ok = clock_plan_solve(&plan, (uint64_t)mode->line_mhz * SYNC_LINE_TICS, (uint64_t)s_res_x * 3 * 1000000000000 / mode->active_ns,
+                                           SYS_CLOCK_MIN_HZ, SYS_CLOCK_MAX_HZ, CLOCK_PPM);
+    const double ns_per_cycle = 1e9 * plan.postdiv1 * plan.postdiv2 / plan.vco_hz;
+    fprintf(stderr, "%s: sys %u Hz, csync %u + %u/256 (%+.3f ppm), rgb %u + %u/256 (%+.3f ppm)%s\n", mode->name, plan.sys_hz,
+            plan.csync_div_int, plan.csync_div_frac, plan.csync_error_ppb / 1000.0, plan.rgb_div_int, plan.rgb_div_frac,
+            plan.rgb_error_ppb / 1000.0, clock_ok ? "" : " out of tolerance");
+
+    // The sync table of video_init().
+    const struct sync_field_t* fields = mode->fields[interlaced];
+    const unsigned field_count = interlaced ? 2 : 1;
+    static uint16_t sync_table[SYNC_TABLE_SIZE];
+    const unsigned sync_entries = sync_build(sync_table, SYNC_TABLE_SIZE, mode->timing, fields, field_count, NULL);
+    if (sync_entries == 0)
+    {
+        fprintf(stderr, "sync table doesn't fit in %d entries\n", SYNC_TABLE_SIZE);
+        return 1;
+    }
+    unsigned sync_index = 0;
+
+    // Lines of a field from the table: half a line per pulse and the half lines.
+    const double tic_us = (plan.csync_div_int + plan.csync_div_frac / 256.0) * ns_per_cycle / 1000;
+    const double rgb_cycle_ns = (plan.rgb_div_int + plan.rgb_div_frac / 256.0) * ns_per_cycle;
+    const double line_us = SYNC_LINE_TICS * tic_us;
+    const struct sync_field_t* field = &fields[0];
+    const double lines_per_field =
+        (field->broad + field->post_equalising + field->pre_equalising + field->half_line_after + field->half_line) / 2.0 +
+        field->lines;
+    const double field_us = lines_per_field * line_us;
+
+    // The display lists of framebuffer.c, black borders. With --check white ones and no black pixels, every line with
+    // irq 0 has pixels from its first to its last one.
+    const unsigned frame_y = RES_Y * field_count / s_line_repeat;
+    static uint8_t framebuffer[MAX_FRAME_Y * MAX_RES_X * 2] __attribute__((aligned(4))); // Halfword pixels.
+    const unsigned border = check_mode ? 7 : 0;
+    static uint32_t border_color;
+    border_color = color_word(border);
+    if (framebuffer_path)
+    {
+        if (!load_framebuffer(framebuffer_path, framebuffer, frame_y))
+        {
+            return 1;
+        }
+    }
+    else if (s_hscroll >= 0)
+    {
+        draw_test_pattern(framebuffer, 2 * s_res_x, RES_Y, 2 * LINE_COUNT, check_mode);
+    }
+    else
+    {
+        draw_test_pattern(framebuffer, s_res_x, frame_y, LINE_COUNT, check_mode);
+    }
+    // The DMA chain of display_list.c on the registers of the host SDK, feeding the rgb state machine.
+    display_list_init(pio0, RGB_SM, LINE_COUNT);
+    static struct control_block_t blocks[2][LIST_BLOCKS];
+    static struct display_list_t lists[2];
+    static uint32_t scroll_words[MAX_PIXELS_PER_WORD + 1];
+    static uint32_t border_line;
+    if (s_hscroll >= 0)
+    {
+        const struct video_scroll_program_t labels = scroll_program(rgb, rgb_offset);
+        for (unsigned pixels = 0; pixels < PIXELS_PER_WORD; pixels++)
+        {
+            scroll_words[pixels] = video_mode_scroll_word(&labels, s_res_x, pixels);
+        }
+        scroll_words[PIXELS_PER_WORD] = video_mode_color_line_word(&labels, s_res_x, color_code(3));
+        border_line = video_mode_color_line_word(&labels, s_res_x, color_code(border));
+        build_scroll_list(&lists[0], blocks[0], framebuffer, scroll_words, &border_line, fields, mode->border_top_lines, check_mode);
+    }
+    else
+    {
+        build_lists(lists, blocks, framebuffer, &border_color, fields, field_count, mode->border_top_lines);
+    }
+    struct dma_model_t dma;
+
+    start(&sim, csync, csync_offset, rgb, rgb_offset, &plan);
+    dma_model_init(&dma, rgb_dreq, rgb_write, &sim);
+    display_list_start();
+
+    static struct timing_check_t check;
+    struct timing_check_config_t config = {0};
+    if (check_mode)
+    {
+        config = (struct timing_check_config_t){
+            .standard = mode->line_mhz == video_mode_pal.line_mhz ? &timing_standard_pal : &timing_standard_ntsc,
+            .line_us = line_us,
+            .lines_per_field = lines_per_field,
+            .broad_pulses = field->broad,
+            .first_line_lines = (field->broad + field->post_equalising) / 2.0,
+            .irq_us = mode->timing->irq * tic_us,
+            .res_x = s_res_x,
+            .rgb_clock_hz = 1e9 / rgb_cycle_ns,
+            .min_active_lines = fields[0].lines,
+            .max_active_lines = fields[0].lines,
+        };
+        for (unsigned i = 0; i < sizeof(s_allowances) / sizeof(s_allowances[0]); i++)
+        {
+            if (s_allowances[i].mode == mode)
+            {
+                config.hsync = s_allowances[i].hsync;
+                config.broad = s_allowances[i].broad;
+                config.equalising = s_allowances[i].equalising;
+            }
+        }
+        for (unsigned i = 1; i < field_count; i++)
+        {
+            config.min_active_lines = fields[i].lines < config.min_active_lines ? fields[i].lines : config.min_active_lines;
+            config.max_active_lines = fields[i].lines > config.max_active_lines ? fields[i].lines : config.max_active_lines;
+        }
+        timing_check_init(&check, &config);
+        if (duration_us == 0)
+        {
+            // CHECK_FIELDS measured from the start, or the restart, the last one ends at the first broad pulse of the
+            // next, a line into it.
+            check_fields = CHECK_FIELDS;
+            duration_us = restart_us + CHECK_FIELDS * field_us + line_us;
+        }
+    }
+    else if (duration_us == 0)
+    {
+        // And the first pulse of the next field, which ends the last line.
+        duration_us = field_us * field_count + line_us;
+    }
+
+    FILE* trace = NULL;
+    if (!check_mode && (output || (!vcd_path && !png_path)))
+    {
+        trace = output ? fopen(output, "w") : stdout;
+        if (!trace)
+        {
+            fprintf(stderr, "%s: can't create\n", output);
+            return 1;
+        }
+    }
+
+    const struct vcd_signal_t vcd_signals[] = {{"csync", 1},   {"red", s_color_bits}, {"green", s_color_bits}, {"blue", s_color_bits},
+                                               {"irq0", 1}, {"dma_block", 8}};
+    struct vcd_t vcd = {0};
+    if (!check_mode && vcd_path && !vcd_open(&vcd, vcd_path, "scart_rgb", vcd_signals, sizeof(vcd_signals) / sizeof(vcd_signals[0])))
+    {
+        fprintf(stderr, "%s: can't create\n", vcd_path);
+        return 1;
+    }
+
+    // Pixel period: 3 cycles of the rgb state machine.
+    struct tv_decode_t tv = {0};
+    if (!check_mode && png_path && !tv_decode_init(&tv, 3.0 * rgb_cycle_ns / 1000, line_us, fields[0].lines, field_count, s_color_bits))
+    {
+        return 1;
+    }
+
+    const uint32_t watched = (1u << CSYNC_PIN) | (RGB_MASK << s_rgb_pin);
+    const uint32_t channel = (1u << s_color_bits) - 1;
+    uint32_t last_pins = sim.pins & watched;
+    for (unsigned pin = 0; trace && pin < 32; pin++)
+    {
+        if (watched & (1u << pin))
+        {
+            fprintf(trace, "0 %u %u\n", pin, (last_pins >> pin) & 1);
+        }
+    }
+
+    const uint64_t cycles = (uint64_t)(duration_us * 1000 / ns_per_cycle);
+    const uint64_t restart = (uint64_t)(restart_us * 1000 / ns_per_cycle);
+    uint64_t irq_count = 0;
+    while (sim.time < cycles)
+    {
+        if (restart && sim.time == restart)
+        {
+            // video_stop() wherever the state machines and the lists are, then video_start(). The irq the aborted
+            // lists may have raised is cleared with ints0, the fields are measured again from here.
+            sim.sm[CSYNC_SM].enabled = false;
+            sim.sm[RGB_SM].enabled = false;
+            display_list_stop();
+            start(&sim, csync, csync_offset, rgb, rgb_offset, &plan);
+            sync_index = 0;
+            dma_model_init(&dma, rgb_dreq, rgb_write, &sim);
+            display_list_start();
+            if (check_mode)
+            {
+                timing_check_init(&check, &config);
+            }
+        }
+
+        // The sync DMA: halfwords, which the bus replicates in both halves of the word.
+        while (pio_sim_get_tx_level(&sim, CSYNC_SM) < PIO_FIFO_DEPTH * 2)
+        {
+            const uint32_t entry = sync_table[sync_index];
+            pio_sim_put(&sim, CSYNC_SM, entry | (entry << 16));
+            sync_index = (sync_index + 1) % sync_entries;
+        }
+
+        dma_model_step(&dma);
+
+        pio_sim_step(&sim);
+
+        const double time_ns = sim.time * ns_per_cycle;
+        const uint32_t pins = sim.pins & watched;
+        uint32_t changed = pins ^ last_pins;
+        last_pins = pins;
+
+        const bool irq = sim.irq_raised[0] != irq_count;
+        irq_count = sim.irq_raised[0];
+
+        if (check_mode)
+        {
+            if (changed & (1u << CSYNC_PIN))
+            {
+                timing_check_csync(&check, time_ns / 1000, (pins >> CSYNC_PIN) & 1);
+            }
+            if (irq)
+            {
+                timing_check_irq(&check, time_ns / 1000);
+            }
+            if (changed & (RGB_MASK << s_rgb_pin))
+            {
+                timing_check_rgb(&check, time_ns / 1000, (pins >> s_rgb_pin) & RGB_MASK);
+            }
+            continue;
+        }
+
+        if (vcd.file)
+        {
+            const uint32_t values[] = {
+                (pins >> CSYNC_PIN) & 1, (pins >> s_rgb_pin) & channel, (pins >> (s_rgb_pin + s_color_bits)) & channel,
+                (pins >> (s_rgb_pin + 2 * s_color_bits)) & channel,
+                (sim.irq & 1), active_block(lists, field_count),
+            };
+            vcd_sample(&vcd, (uint64_t)time_ns, values);
+        }
+
+        if (tv.rgb)
+        {
+            tv_decode_sample(&tv, time_ns / 1000, (pins >> CSYNC_PIN) & 1, (pins >> s_rgb_pin) & RGB_MASK);
+        }
+
+        while (trace && changed)
+        {
+            const unsigned pin = __builtin_ctz(changed);
+            changed &= changed - 1;
+            fprintf(trace, "%.0f %u %u\n", time_ns, pin, (pins >> pin) & 1);
+        }
+    }
+
+    if (check_mode)
+    {
+        bool pass = timing_check_report(&check, stdout);
+        if (check.fields < check_fields)
+        {
+            printf("%u fields measured instead of %u\n", check.fields, check_fields);
+            pass = false;
+        }
+        return pass ? 0 : 1;
+    }
+
+    int result = 0;
+    if (tv.rgb)
+    {
+        if (!tv.done)
+        {
+            fprintf(stderr, "%s: no complete %s in %.0f us\n", png_path, interlaced ? "frame" : "field", duration_us);
+        }
+        if (!png_write_rgb(png_path, tv.rgb, tv.width, tv.height))
+        {
+            fprintf(stderr, "%s: can't write\n", png_path);
+            result = 1;
+        }
+        tv_decode_free(&tv);
+    }
+    vcd_close(&vcd);
+    if (trace && trace != stdout)
+    {
+        fclose(trace);
+    }
+    return result;
+}
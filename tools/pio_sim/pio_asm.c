@@ -0,0 +1,841 @@
+/**
+ * Minimal PIO assembler, see pio_asm.h.
+ */
+#include "pio_asm.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define MAX_LINES 1024
+#define MAX_LINE_LENGTH 256
+#define MAX_WORDS 16
+
+// Instruction classes, bits 15-13.
+#define OP_JMP 0x0000
+#define OP_WAIT 0x2000
+#define OP_IN 0x4000
+#define OP_OUT 0x6000
+#define OP_PUSH_PULL 0x8000
+#define OP_MOV 0xa000
+#define OP_IRQ 0xc000
+#define OP_SET 0xe000
+
+struct context_t
+{
+    const char* path;
+    int line;
+    bool encode; // false in the first pass, which only collects labels and defines.
+    struct pio_source_t* source;
+    struct pio_program_t* program;
+    struct pio_symbol_t globals[PIO_ASM_MAX_SYMBOLS];
+    unsigned global_count;
+    bool failed;
+};
+
+static void error(struct context_t* context, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%s:%d: error: ", context->path, context->line);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    context->failed = true;
+}
+
+static char* trim(char* text)
+{
+    while (isspace((unsigned char)*text))
+    {
+        text++;
+    }
+    char* end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1]))
+    {
+        *--end = '\0';
+    }
+    return text;
+}
+
+static bool add_symbol(struct context_t* context, const char* name, int value)
+{
+    struct pio_symbol_t* symbols = context->program ? context->program->symbols : context->globals;
+    unsigned* count = context->program ? &context->program->symbol_count : &context->global_count;
+
+    for (unsigned i = 0; i < *count; i++)
+    {
+        if (strcmp(symbols[i].name, name) == 0)
+        {
+            symbols[i].value = value; // Second pass, same value.
+            return true;
+        }
+    }
+    if (*count == PIO_ASM_MAX_SYMBOLS || strlen(name) >= PIO_ASM_NAME_LENGTH)
+    {
+        error(context, "too many symbols or name too long: %s", name);
+        return false;
+    }
+    snprintf(symbols[*count].name, PIO_ASM_NAME_LENGTH, "%s", name);
+    symbols[*count].value = value;
+    (*count)++;
+    return true;
+}
+
+static bool find_symbol(const struct context_t* context, const char* name, int* value)
+{
+    if (context->program && pio_asm_find_symbol(context->program, name, value))
+    {
+        return true;
+    }
+    for (unsigned i = 0; i < context->global_count; i++)
+    {
+        if (strcmp(context->globals[i].name, name) == 0)
+        {
+            *value = context->globals[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// Expressions: numbers (decimal, 0x, 0b), symbols, + - * / and parentheses.
+
+struct parser_t
+{
+    struct context_t* context;
+    const char* p;
+};
+
+static int parse_expression(struct parser_t* parser);
+
+static void skip_spaces(struct parser_t* parser)
+{
+    while (isspace((unsigned char)*parser->p))
+    {
+        parser->p++;
+    }
+}
+
+static int parse_factor(struct parser_t* parser)
+{
+    skip_spaces(parser);
+    const char* p = parser->p;
+
+    if (*p == '(')
+    {
+        parser->p++;
+        const int value = parse_expression(parser);
+        skip_spaces(parser);
+        if (*parser->p != ')')
+        {
+            error(parser->context, "missing ')'");
+            return 0;
+        }
+        parser->p++;
+        return value;
+    }
+    if (*p == '-')
+    {
+        parser->p++;
+        return -parse_factor(parser);
+    }
+    if (isdigit((unsigned char)*p))
+    {
+        char* end;
+        long value;
+        if (p[0] == '0' && (p[1] == 'b' || p[1] == 'B'))
+        {
+            value = strtol(p + 2, &end, 2);
+        }
+        else
+        {
+            value = strtol(p, &end, 0);
+        }
+        parser->p = end;
+        return (int)value;
+    }
+    if (isalpha((unsigned char)*p) || *p == '_')
+    {
+        char name[PIO_ASM_NAME_LENGTH];
+        unsigned length = 0;
+        while ((isalnum((unsigned char)*p) || *p == '_') && length < sizeof(name) - 1)
+        {
+            name[length++] = *p++;
+        }
+        name[length] = '\0';
+        parser->p = p;
+
+        int value = 0;
+        if (!find_symbol(parser->context, name, &value) && parser->context->encode)
+        {
+            error(parser->context, "unknown symbol '%s'", name);
+        }
+        return value;
+    }
+
+    error(parser->context, "bad expression '%s'", p);
+    parser->p += strlen(p);
+    return 0;
+}
+
+static int parse_term(struct parser_t* parser)
+{
+    int value = parse_factor(parser);
+    while (true)
+    {
+        skip_spaces(parser);
+        const char op = *parser->p;
+        if (op != '*' && op != '/')
+        {
+            return value;
+        }
+        parser->p++;
+        const int rhs = parse_factor(parser);
+        if (op == '*')
+        {
+            value *= rhs;
+        }
+        else if (rhs != 0)
+        {
+            value /= rhs;
+        }
+        else
+        {
+            error(parser->context, "division by zero");
+        }
+    }
+}
+
+static int parse_expression(struct parser_t* parser)
+{
+    int value = parse_term(parser);
+    while (true)
+    {
+        skip_spaces(parser);
+        const char op = *parser->p;
+        if (op != '+' && op != '-')
+        {
+            return value;
+        }
+        parser->p++;
+        const int rhs = parse_term(parser);
+        value = (op == '+') ? value + rhs : value - rhs;
+    }
+}
+
+static int evaluate(struct context_t* context, const char* text)
+{
+    struct parser_t parser = {context, text};
+    const int value = parse_expression(&parser);
+    skip_spaces(&parser);
+    if (*parser.p)
+    {
+        error(context, "unexpected '%s'", parser.p);
+    }
+    return value;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// Instructions.
+
+// Split on spaces and commas.
+static unsigned split_words(char* text, char* words[MAX_WORDS])
+{
+    unsigned count = 0;
+    char* token = strtok(text, " \t,");
+    while (token && count < MAX_WORDS)
+    {
+        words[count++] = token;
+        token = strtok(NULL, " \t,");
+    }
+    return count;
+}
+
+// Join words[first..count) back into one expression.
+static int evaluate_words(struct context_t* context, char* words[], unsigned first, unsigned count)
+{
+    char text[MAX_LINE_LENGTH] = "";
+    for (unsigned i = first; i < count; i++)
+    {
+        strncat(text, words[i], sizeof(text) - strlen(text) - 2);
+        strcat(text, " ");
+    }
+    if (first >= count)
+    {
+        error(context, "missing operand");
+        return 0;
+    }
+    return evaluate(context, text);
+}
+
+static int lookup(const char* word, const char* const names[], const int values[], unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (strcmp(word, names[i]) == 0)
+        {
+            return values[i];
+        }
+    }
+    return -1;
+}
+
+// Bit count of in/out/push thresholds: 32 is encoded as 0.
+static uint16_t encode_bit_count(struct context_t* context, int count)
+{
+    if (count < 1 || count > 32)
+    {
+        error(context, "bit count %d out of range", count);
+    }
+    return count & 0x1f;
+}
+
+static uint16_t encode_irq_index(struct context_t* context, char* words[], unsigned first, unsigned count)
+{
+    bool relative = false;
+    if (count > first && strcmp(words[count - 1], "rel") == 0)
+    {
+        relative = true;
+        count--;
+    }
+    const int index = evaluate_words(context, words, first, count);
+    if (index < 0 || index > 7)
+    {
+        error(context, "irq index %d out of range", index);
+    }
+    return (relative ? 0x10 : 0) | (index & 7);
+}
+
+static uint16_t encode_instruction(struct context_t* context, char* words[], unsigned count)
+{
+    static const char* const in_sources[] = {"pins", "x", "y", "null", "isr", "osr"};
+    static const int in_values[] = {0, 1, 2, 3, 6, 7};
+    static const char* const out_destinations[] = {"pins", "x", "y", "null", "pindirs", "pc", "isr", "exec"};
+    static const int out_values[] = {0, 1, 2, 3, 4, 5, 6, 7};
+    static const char* const mov_destinations[] = {"pins", "x", "y", "exec", "pc", "isr", "osr"};
+    static const int mov_destination_values[] = {0, 1, 2, 4, 5, 6, 7};
+    static const char* const mov_sources[] = {"pins", "x", "y", "null", "status", "isr", "osr"};
+    static const int mov_source_values[] = {0, 1, 2, 3, 5, 6, 7};
+    static const char* const set_destinations[] = {"pins", "x", "y", "pindirs"};
+    static const int set_values[] = {0, 1, 2, 4};
+    static const char* const conditions[] = {"!x", "x--", "!y", "y--", "x!=y", "pin", "!osre"};
+    static const int condition_values[] = {1, 2, 3, 4, 5, 6, 7};
+
+    const char* op = words[0];
+
+    if (strcmp(op, "nop") == 0)
+    {
+        return OP_MOV | (2 << 5) | 2; // mov y, y
+    }
+    if (strcmp(op, "jmp") == 0)
+    {
+        int condition = 0;
+        unsigned first = 1;
+        if (count > 2)
+        {
+            condition = lookup(words[1], conditions, condition_values, 7);
+            if (condition < 0)
+            {
+                error(context, "bad jmp condition '%s'", words[1]);
+                condition = 0;
+            }
+            first = 2;
+        }
+        const int target = evaluate_words(context, words, first, count);
+        return OP_JMP | (condition << 5) | (target & 0x1f);
+    }
+    if (strcmp(op, "wait") == 0)
+    {
+        if (count < 4)
+        {
+            error(context, "wait <polarity> gpio|pin|irq <index>");
+            return 0;
+        }
+        const int polarity = evaluate(context, words[1]);
+        static const char* const sources[] = {"gpio", "pin", "irq"};
+        static const int source_values[] = {0, 1, 2};
+        const int source = lookup(words[2], sources, source_values, 3);
+        if (source < 0)
+        {
+            error(context, "bad wait source '%s'", words[2]);
+            return 0;
+        }
+        const uint16_t index = (source == 2) ? encode_irq_index(context, words, 3, count) : (evaluate_words(context, words, 3, count) & 0x1f);
+        return OP_WAIT | ((polarity & 1) << 7) | (source << 5) | index;
+    }
+    if (strcmp(op, "in") == 0 || strcmp(op, "out") == 0)
+    {
+        const bool is_in = (op[0] == 'i');
+        if (count < 3)
+        {
+            error(context, "%s <target>, <bit count>", op);
+            return 0;
+        }
+        const int target = is_in ? lookup(words[1], in_sources, in_values, 6) : lookup(words[1], out_destinations, out_values, 8);
+        if (target < 0)
+        {
+            error(context, "bad %s target '%s'", op, words[1]);
+            return 0;
+        }
+        return (is_in ? OP_IN : OP_OUT) | (target << 5) | encode_bit_count(context, evaluate_words(context, words, 2, count));
+    }
+    if (strcmp(op, "push") == 0 || strcmp(op, "pull") == 0)
+    {
+        const bool is_pull = (op[1] == 'u' && op[2] == 'l');
+        bool block = true;
+        bool if_flag = false;
+        for (unsigned i = 1; i < count; i++)
+        {
+            if (strcmp(words[i], "block") == 0)
+            {
+                block = true;
+            }
+            else if (strcmp(words[i], "noblock") == 0)
+            {
+                block = false;
+            }
+            else if (strcmp(words[i], is_pull ? "ifempty" : "iffull") == 0)
+            {
+                if_flag = true;
+            }
+            else
+            {
+                error(context, "bad %s option '%s'", op, words[i]);
+            }
+        }
+        return OP_PUSH_PULL | (is_pull ? 0x80 : 0) | (if_flag ? 0x40 : 0) | (block ? 0x20 : 0);
+    }
+    if (strcmp(op, "mov") == 0)
+    {
+        if (count < 3)
+        {
+            error(context, "mov <destination>, <source>");
+            return 0;
+        }
+        const int destination = lookup(words[1], mov_destinations, mov_destination_values, 7);
+        const char* source_name = words[2];
+        int operation = 0;
+        if (source_name[0] == '!' || source_name[0] == '~')
+        {
+            operation = 1;
+            source_name++;
+        }
+        else if (strncmp(source_name, "::", 2) == 0)
+        {
+            operation = 2;
+            source_name += 2;
+        }
+        if (!*source_name && count > 3)
+        {
+            source_name = words[3];
+        }
+        const int source = lookup(source_name, mov_sources, mov_source_values, 7);
+        if (destination < 0 || source < 0)
+        {
+            error(context, "bad mov operands");
+            return 0;
+        }
+        return OP_MOV | (destination << 5) | (operation << 3) | source;
+    }
+    if (strcmp(op, "irq") == 0)
+    {
+        unsigned first = 1;
+        uint16_t mode = 0; // set / nowait
+        if (count > 2)
+        {
+            if (strcmp(words[1], "wait") == 0)
+            {
+                mode = 0x20;
+                first = 2;
+            }
+            else if (strcmp(words[1], "clear") == 0)
+            {
+                mode = 0x40;
+                first = 2;
+            }
+            else if (strcmp(words[1], "set") == 0 || strcmp(words[1], "nowait") == 0)
+            {
+                first = 2;
+            }
+        }
+        return OP_IRQ | mode | encode_irq_index(context, words, first, count);
+    }
+    if (strcmp(op, "set") == 0)
+    {
+        if (count < 3)
+        {
+            error(context, "set <destination>, <value>");
+            return 0;
+        }
+        const int destination = lookup(words[1], set_destinations, set_values, 4);
+        const int value = evaluate_words(context, words, 2, count);
+        if (destination < 0 || value < 0 || value > 31)
+        {
+            error(context, "bad set operands");
+            return 0;
+        }
+        return OP_SET | (destination << 5) | value;
+    }
+
+    error(context, "unknown instruction '%s'", op);
+    return 0;
+}
+
+// Delay and side-set share bits 12-8.
+static uint16_t encode_delay_sideset(struct context_t* context, const char* delay_text, const char* sideset_text)
+{
+    const struct pio_program_t* program = context->program;
+    const unsigned delay_bits = 5 - program->sideset_count;
+    uint16_t field = 0;
+
+    if (delay_text)
+    {
+        const int delay = evaluate(context, delay_text);
+        if (delay < 0 || delay >= (1 << delay_bits))
+        {
+            error(context, "delay %d doesn't fit in %u bits", delay, delay_bits);
+        }
+        field |= delay & ((1 << delay_bits) - 1);
+    }
+
+    if (sideset_text)
+    {
+        if (program->sideset_count == 0)
+        {
+            error(context, "side-set without .side_set");
+            return field;
+        }
+        const unsigned value_bits = program->sideset_count - (program->sideset_opt ? 1 : 0);
+        const int value = evaluate(context, sideset_text);
+        if (value < 0 || value >= (1 << value_bits))
+        {
+            error(context, "side-set value %d doesn't fit in %u bits", value, value_bits);
+        }
+        uint16_t sideset = value & ((1 << value_bits) - 1);
+        if (program->sideset_opt)
+        {
+            sideset |= 1 << value_bits;
+        }
+        field |= sideset << delay_bits;
+    }
+    else if (program->sideset_count && !program->sideset_opt)
+    {
+        error(context, "side-set value required");
+    }
+
+    return field << 8;
+}
+
+static void assemble_instruction(struct context_t* context, char* text)
+{
+    struct pio_program_t* program = context->program;
+    if (!program)
+    {
+        error(context, "instruction outside of a .program");
+        return;
+    }
+    if (program->length == PIO_INSTRUCTION_COUNT)
+    {
+        error(context, "program longer than %d instructions", PIO_INSTRUCTION_COUNT);
+        return;
+    }
+
+    if (!context->encode)
+    {
+        program->length++;
+        return;
+    }
+
+    // [delay] at the end, then "side <value>".
+    char* delay_text = NULL;
+    char* bracket = strchr(text, '[');
+    if (bracket)
+    {
+        char* close = strchr(bracket, ']');
+        if (!close)
+        {
+            error(context, "missing ']'");
+            return;
+        }
+        *close = '\0';
+        *bracket = '\0';
+        delay_text = bracket + 1;
+    }
+
+    char* sideset_text = NULL;
+    for (char* side = strstr(text, "side"); side; side = strstr(side + 1, "side"))
+    {
+        const bool starts_word = side > text && isspace((unsigned char)side[-1]);
+        const char* after = side + 4;
+        if (strncmp(after, "set", 3) == 0)
+        {
+            after += 3;
+        }
+        if (starts_word && isspace((unsigned char)*after))
+        {
+            *side = '\0';
+            sideset_text = (char*)after;
+            break;
+        }
+    }
+
+    char* words[MAX_WORDS];
+    const unsigned count = split_words(text, words);
+    if (count == 0)
+    {
+        error(context, "empty instruction");
+        return;
+    }
+
+    const uint16_t instruction = encode_instruction(context, words, count);
+    program->instructions[program->length++] = instruction | encode_delay_sideset(context, delay_text, sideset_text);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void assemble_directive(struct context_t* context, char* text, int* wrap_target, int* wrap)
+{
+    char* words[MAX_WORDS];
+    const unsigned count = split_words(text, words);
+    if (count == 0)
+    {
+        error(context, "empty directive");
+        return;
+    }
+    const char* directive = words[0];
+
+    if (strcmp(directive, ".program") == 0)
+    {
+        if (count < 2 || context->source->program_count == PIO_ASM_MAX_PROGRAMS)
+        {
+            error(context, "bad .program");
+            return;
+        }
+        struct pio_program_t* program = &context->source->programs[context->source->program_count++];
+        if (!context->encode)
+        {
+            memset(program, 0, sizeof(*program));
+            snprintf(program->name, sizeof(program->name), "%s", words[1]);
+        }
+        program->length = 0;
+        context->program = program;
+        *wrap_target = -1;
+        *wrap = -1;
+    }
+    else if (strcmp(directive, ".define") == 0)
+    {
+        unsigned first = 1;
+        if (count > 1 && strcasecmp(words[1], "PUBLIC") == 0)
+        {
+            first = 2;
+        }
+        if (count < first + 2)
+        {
+            error(context, "bad .define");
+            return;
+        }
+        add_symbol(context, words[first], evaluate_words(context, words, first + 1, count));
+    }
+    else if (strcmp(directive, ".wrap_target") == 0)
+    {
+        *wrap_target = context->program ? context->program->length : 0;
+    }
+    else if (strcmp(directive, ".wrap") == 0)
+    {
+        *wrap = context->program ? context->program->length - 1 : 0;
+    }
+    else if (strcmp(directive, ".side_set") == 0)
+    {
+        if (!context->program || count < 2)
+        {
+            error(context, "bad .side_set");
+            return;
+        }
+        context->program->sideset_count = evaluate(context, words[1]);
+        for (unsigned i = 2; i < count; i++)
+        {
+            if (strcmp(words[i], "opt") == 0)
+            {
+                context->program->sideset_opt = true;
+                context->program->sideset_count++;
+            }
+            else if (strcmp(words[i], "pindirs") == 0)
+            {
+                context->program->sideset_pindirs = true;
+            }
+        }
+        if (context->program->sideset_count > 5)
+        {
+            error(context, "too many side-set bits");
+        }
+    }
+    else if (strcmp(directive, ".origin") == 0 || strcmp(directive, ".lang_opt") == 0 || strcmp(directive, ".pio_version") == 0)
+    {
+        // Nothing to do for the simulator.
+    }
+    else
+    {
+        error(context, "unknown directive '%s'", directive);
+    }
+}
+
+static void close_program(struct context_t* context, int wrap_target, int wrap)
+{
+    struct pio_program_t* program = context->program;
+    if (!program)
+    {
+        return;
+    }
+    program->wrap_target = wrap_target >= 0 ? wrap_target : 0;
+    program->wrap = wrap >= 0 ? wrap : (program->length ? program->length - 1 : 0);
+}
+
+static void assemble_pass(struct context_t* context, char lines[][MAX_LINE_LENGTH], int line_count)
+{
+    bool in_code_block = false;
+    int wrap_target = -1;
+    int wrap = -1;
+
+    context->program = NULL;
+    context->source->program_count = 0;
+
+    for (int i = 0; i < line_count; i++)
+    {
+        char buffer[MAX_LINE_LENGTH];
+        memcpy(buffer, lines[i], MAX_LINE_LENGTH);
+        context->line = i + 1;
+
+        char* text = trim(buffer);
+        if (in_code_block)
+        {
+            in_code_block = strncmp(text, "%}", 2) != 0;
+            continue;
+        }
+        if (text[0] == '%')
+        {
+            in_code_block = true;
+            continue;
+        }
+
+        // Comments.
+        char* comment = strchr(text, ';');
+        if (comment)
+        {
+            *comment = '\0';
+        }
+        comment = strstr(text, "//");
+        if (comment)
+        {
+            *comment = '\0';
+        }
+        text = trim(text);
+        if (!*text)
+        {
+            continue;
+        }
+
+        if (text[0] == '.')
+        {
+            if (strncmp(text, ".program", 8) == 0)
+            {
+                close_program(context, wrap_target, wrap);
+            }
+            assemble_directive(context, text, &wrap_target, &wrap);
+            continue;
+        }
+
+        // Label, maybe followed by an instruction.
+        char* colon = strchr(text, ':');
+        if (colon && (colon[1] != ':') && (colon == text || colon[-1] != ':'))
+        {
+            *colon = '\0';
+            char* name = trim(text);
+            if (strncasecmp(name, "PUBLIC", 6) == 0 && isspace((unsigned char)name[6]))
+            {
+                name = trim(name + 6);
+            }
+            if (!context->program)
+            {
+                error(context, "label outside of a .program");
+                continue;
+            }
+            add_symbol(context, name, context->program->length);
+            text = trim(colon + 1);
+            if (!*text)
+            {
+                continue;
+            }
+        }
+
+        assemble_instruction(context, text);
+    }
+
+    close_program(context, wrap_target, wrap);
+}
+
+bool pio_asm_file(const char* path, struct pio_source_t* source)
+{
+    static char lines[MAX_LINES][MAX_LINE_LENGTH];
+
+    FILE* file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "%s: can't open\n", path);
+        return false;
+    }
+
+    int line_count = 0;
+    while (line_count < MAX_LINES && fgets(lines[line_count], MAX_LINE_LENGTH, file))
+    {
+        lines[line_count][strcspn(lines[line_count], "\r\n")] = '\0';
+        line_count++;
+    }
+    fclose(file);
+
+    struct context_t context;
+    memset(&context, 0, sizeof(context));
+    memset(source, 0, sizeof(*source));
+    context.path = path;
+    context.source = source;
+
+    // First pass for the labels, so jumps forward resolve in the second one.
+    assemble_pass(&context, lines, line_count);
+    if (!context.failed)
+    {
+        context.encode = true;
+        context.global_count = 0;
+        assemble_pass(&context, lines, line_count);
+    }
+
+    return !context.failed;
+}
+
+const struct pio_program_t* pio_asm_find_program(const struct pio_source_t* source, const char* name)
+{
+    for (unsigned i = 0; i < source->program_count; i++)
+    {
+        if (strcmp(source->programs[i].name, name) == 0)
+        {
+            return &source->programs[i];
+        }
+    }
+    return NULL;
+}
+
+bool pio_asm_find_symbol(const struct pio_program_t* program, const char* name, int* value)
+{
+    for (unsigned i = 0; i < program->symbol_count; i++)
+    {
+        if (strcmp(program->symbols[i].name, name) == 0)
+        {
+            *value = program->symbols[i].value;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+/**
+ * Minimal PIO assembler, enough for the .pio files of this repo.
+ *
+ * Reads a .pio source with the same syntax as pioasm (.program, .define, .wrap_target,
+ * .wrap, .side_set, labels, delays and side-set values, % c-sdk blocks are skipped) and
+ * produces the 16-bit machine code, so the simulator runs exactly what gets loaded in the
+ * PIO instruction memory.
+ */
+#ifndef PIO_ASM_H
+#define PIO_ASM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PIO_INSTRUCTION_COUNT 32
+#define PIO_ASM_MAX_PROGRAMS 8
+#define PIO_ASM_MAX_SYMBOLS 64
+#define PIO_ASM_NAME_LENGTH 32
+
+struct pio_symbol_t
+{
+    char name[PIO_ASM_NAME_LENGTH];
+    int value;
+};
+
+struct pio_program_t
+{
+    char name[PIO_ASM_NAME_LENGTH];
+    uint16_t instructions[PIO_INSTRUCTION_COUNT];
+    uint8_t length;
+    uint8_t wrap_target;
+    uint8_t wrap;
+    uint8_t sideset_count; // Including the enable bit when optional.
+    bool sideset_opt;
+    bool sideset_pindirs;
+
+    // Labels and .define of the program.
+    struct pio_symbol_t symbols[PIO_ASM_MAX_SYMBOLS];
+    unsigned symbol_count;
+};
+
+struct pio_source_t
+{
+    struct pio_program_t programs[PIO_ASM_MAX_PROGRAMS];
+    unsigned program_count;
+};
+
+// Assemble a .pio file. On error prints file:line and the reason to stderr and returns false.
+bool pio_asm_file(const char* path, struct pio_source_t* source);
+
+// Program by name, NULL if the source doesn't have it.
+const struct pio_program_t* pio_asm_find_program(const struct pio_source_t* source, const char* name);
+
+// Value of a label or .define of the program, false if it doesn't exist.
+bool pio_asm_find_symbol(const struct pio_program_t* program, const char* name, int* value);
+
+#endif
@@ -0,0 +1,599 @@
+/**
+ * PIO simulator, see pio_sim.h.
+ */
+#include "pio_sim.h"
+
+#include <string.h>
+
+#define OP_JMP 0
+#define OP_WAIT 1
+#define OP_IN 2
+#define OP_OUT 3
+#define OP_PUSH_PULL 4
+#define OP_MOV 5
+#define OP_IRQ 6
+#define OP_SET 7
+
+static void fifo_reset(struct pio_sim_fifo_t* fifo, unsigned depth)
+{
+    fifo->head = 0;
+    fifo->level = 0;
+    fifo->depth = depth;
+}
+
+static bool fifo_push(struct pio_sim_fifo_t* fifo, uint32_t data)
+{
+    if (fifo->level == fifo->depth)
+    {
+        return false;
+    }
+    fifo->data[(fifo->head + fifo->level) % (PIO_FIFO_DEPTH * 2)] = data;
+    fifo->level++;
+    return true;
+}
+
+static bool fifo_pop(struct pio_sim_fifo_t* fifo, uint32_t* data)
+{
+    if (fifo->level == 0)
+    {
+        return false;
+    }
+    *data = fifo->data[fifo->head];
+    fifo->head = (fifo->head + 1) % (PIO_FIFO_DEPTH * 2);
+    fifo->level--;
+    return true;
+}
+
+void pio_sim_init(struct pio_sim_t* sim)
+{
+    memset(sim, 0, sizeof(*sim));
+    for (unsigned i = 0; i < PIO_SM_COUNT; i++)
+    {
+        fifo_reset(&sim->sm[i].tx, PIO_FIFO_DEPTH);
+        fifo_reset(&sim->sm[i].rx, PIO_FIFO_DEPTH);
+    }
+}
+
+int pio_sim_add_program(struct pio_sim_t* sim, const struct pio_program_t* program)
+{
+    // The SDK places programs from the top of the memory down.
+    const uint32_t program_mask = (program->length == 32) ? 0xffffffffu : (1u << program->length) - 1;
+    for (int offset = PIO_INSTRUCTION_COUNT - program->length; offset >= 0; offset--)
+    {
+        if (sim->used_mask & (program_mask << offset))
+        {
+            continue;
+        }
+
+        for (unsigned i = 0; i < program->length; i++)
+        {
+            uint16_t instruction = program->instructions[i];
+            if ((instruction >> 13) == OP_JMP)
+            {
+                instruction = (instruction & ~0x1f) | ((instruction + offset) & 0x1f);
+            }
+            sim->instructions[offset + i] = instruction;
+        }
+        sim->used_mask |= program_mask << offset;
+        return offset;
+    }
+    return -1;
+}
+
+struct pio_sim_config_t pio_sim_get_default_config(const struct pio_program_t* program, unsigned offset)
+{
+    struct pio_sim_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.wrap_target = offset + program->wrap_target;
+    config.wrap = offset + program->wrap;
+    config.sideset_count = program->sideset_count;
+    config.sideset_opt = program->sideset_opt;
+    config.sideset_pindirs = program->sideset_pindirs;
+    config.out_count = 32;
+    config.out_shift_right = true;
+    config.in_shift_right = true;
+    config.pull_threshold = 32;
+    config.push_threshold = 32;
+    config.clkdiv_int = 1;
+    return config;
+}
+
+void pio_sim_config_set_clkdiv(struct pio_sim_config_t* config, float div)
+{
+    config->clkdiv_int = (uint16_t)div;
+    config->clkdiv_frac = (uint8_t)((div - config->clkdiv_int) * 256);
+}
+
+void pio_sim_sm_init(struct pio_sim_t* sim, unsigned sm, unsigned initial_pc, const struct pio_sim_config_t* config)
+{
+    struct pio_sim_sm_t* state = &sim->sm[sm];
+    memset(state, 0, sizeof(*state));
+    state->config = *config;
+    state->pc = initial_pc;
+    state->osr_count = 32; // Empty.
+
+    fifo_reset(&state->tx, config->join_tx ? PIO_FIFO_DEPTH * 2 : (config->join_rx ? 0 : PIO_FIFO_DEPTH));
+    fifo_reset(&state->rx, config->join_rx ? PIO_FIFO_DEPTH * 2 : (config->join_tx ? 0 : PIO_FIFO_DEPTH));
+}
+
+static uint32_t divider_256(const struct pio_sim_config_t* config)
+{
+    // clkdiv 0 means 65536.
+    const uint32_t div = config->clkdiv_int ? config->clkdiv_int : 65536;
+    return (div << 8) | config->clkdiv_frac;
+}
+
+void pio_sim_enable_sm_mask_in_sync(struct pio_sim_t* sim, uint32_t mask)
+{
+    for (unsigned i = 0; i < PIO_SM_COUNT; i++)
+    {
+        if (mask & (1u << i))
+        {
+            // Every state machine runs its first cycle on the next system clock.
+            sim->sm[i].clock_acc = divider_256(&sim->sm[i].config) - 256;
+            sim->sm[i].enabled = true;
+        }
+    }
+}
+
+bool pio_sim_put(struct pio_sim_t* sim, unsigned sm, uint32_t data)
+{
+    return fifo_push(&sim->sm[sm].tx, data);
+}
+
+bool pio_sim_get(struct pio_sim_t* sim, unsigned sm, uint32_t* data)
+{
+    return fifo_pop(&sim->sm[sm].rx, data);
+}
+
+unsigned pio_sim_get_tx_level(const struct pio_sim_t* sim, unsigned sm)
+{
+    return sim->sm[sm].tx.level;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void write_pins(uint32_t* pins, unsigned base, unsigned count, uint32_t value)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        const uint32_t bit = 1u << ((base + i) & 31);
+        *pins = (value & (1u << i)) ? (*pins | bit) : (*pins & ~bit);
+    }
+}
+
+static uint32_t read_pins(const struct pio_sim_t* sim, unsigned base)
+{
+    const uint32_t levels = (sim->pins & sim->pindirs) | (sim->pins_in & ~sim->pindirs);
+    return base ? (levels >> base) | (levels << (32 - base)) : levels;
+}
+
+static uint32_t bit_mask(unsigned count)
+{
+    return (count >= 32) ? 0xffffffffu : (1u << count) - 1;
+}
+
+static uint32_t reverse_bits(uint32_t value)
+{
+    uint32_t result = 0;
+    for (unsigned i = 0; i < 32; i++)
+    {
+        result = (result << 1) | ((value >> i) & 1);
+    }
+    return result;
+}
+
+static unsigned irq_index(unsigned sm, unsigned index)
+{
+    // Relative: the two lsb are added to the state machine number, bit 2 stays.
+    if (index & 0x10)
+    {
+        return (index & 4) | ((index + sm) & 3);
+    }
+    return index & 7;
+}
+
+// Flags are read as they were at the start of the cycle, changes land at its end.
+static bool irq_get(const struct pio_sim_t* sim, unsigned index)
+{
+    return (sim->irq >> index) & 1;
+}
+
+static void irq_set(struct pio_sim_t* sim, unsigned index)
+{
+    sim->irq_set |= 1u << index;
+}
+
+static void irq_clear(struct pio_sim_t* sim, unsigned index)
+{
+    sim->irq_clear |= 1u << index;
+}
+
+static bool osr_empty(const struct pio_sim_sm_t* state)
+{
+    return state->osr_count >= state->config.pull_threshold;
+}
+
+static void pull_osr(struct pio_sim_sm_t* state, uint32_t data)
+{
+    state->osr = data;
+    state->osr_count = 0;
+}
+
+static uint32_t shift_out(struct pio_sim_sm_t* state, unsigned count)
+{
+    uint32_t data;
+    if (state->config.out_shift_right)
+    {
+        data = state->osr & bit_mask(count);
+        state->osr = (count >= 32) ? 0 : state->osr >> count;
+    }
+    else
+    {
+        data = (count >= 32) ? state->osr : state->osr >> (32 - count);
+        state->osr = (count >= 32) ? 0 : state->osr << count;
+    }
+    state->osr_count = (state->osr_count + count > 32) ? 32 : state->osr_count + count;
+    return data;
+}
+
+static void shift_in(struct pio_sim_sm_t* state, uint32_t data, unsigned count)
+{
+    data &= bit_mask(count);
+    if (state->config.in_shift_right)
+    {
+        state->isr = (count >= 32) ? data : (state->isr >> count) | (data << (32 - count));
+    }
+    else
+    {
+        state->isr = (count >= 32) ? data : (state->isr << count) | data;
+    }
+    state->isr_count = (state->isr_count + count > 32) ? 32 : state->isr_count + count;
+}
+
+static void push_isr(struct pio_sim_sm_t* state)
+{
+    fifo_push(&state->rx, state->isr);
+    state->isr = 0;
+    state->isr_count = 0;
+}
+
+// Execute one instruction, returns false if it stalls. The next pc is left in *next_pc.
+static bool execute(struct pio_sim_t* sim, unsigned sm, uint16_t instruction, uint8_t* next_pc)
+{
+    struct pio_sim_sm_t* state = &sim->sm[sm];
+    const struct pio_sim_config_t* config = &state->config;
+    const unsigned op = instruction >> 13;
+    const unsigned arg1 = (instruction >> 5) & 7;
+    const unsigned arg2 = instruction & 0x1f;
+    const unsigned bit_count = arg2 ? arg2 : 32;
+
+    switch (op)
+    {
+    case OP_JMP:
+    {
+        bool taken;
+        switch (arg1)
+        {
+        case 0: taken = true; break;
+        case 1: taken = state->x == 0; break;
+        case 2: taken = state->x-- != 0; break;
+        case 3: taken = state->y == 0; break;
+        case 4: taken = state->y-- != 0; break;
+        case 5: taken = state->x != state->y; break;
+        case 6: taken = (read_pins(sim, 0) >> config->jmp_pin) & 1; break;
+        default: taken = !osr_empty(state); break;
+        }
+        if (taken)
+        {
+            *next_pc = arg2;
+        }
+        return true;
+    }
+
+    case OP_WAIT:
+    {
+        const unsigned polarity = (instruction >> 7) & 1;
+        const unsigned source = arg1 & 3;
+        unsigned level;
+        if (source == 0)
+        {
+            level = (read_pins(sim, 0) >> arg2) & 1;
+        }
+        else if (source == 1)
+        {
+            level = read_pins(sim, config->in_base) >> arg2 & 1;
+        }
+        else
+        {
+            const unsigned index = irq_index(sm, arg2);
+            level = irq_get(sim, index);
+            if (level && polarity)
+            {
+                irq_clear(sim, index);
+            }
+        }
+        return level == polarity;
+    }
+
+    case OP_IN:
+    {
+        if (config->autopush && state->isr_count >= config->push_threshold)
+        {
+            // A previous push couldn't happen because the RX FIFO was full.
+            if (state->rx.level == state->rx.depth)
+            {
+                return false;
+            }
+            push_isr(state);
+        }
+
+        uint32_t data;
+        switch (arg1)
+        {
+        case 0: data = read_pins(sim, config->in_base); break;
+        case 1: data = state->x; break;
+        case 2: data = state->y; break;
+        case 6: data = state->isr; break;
+        case 7: data = state->osr; break;
+        default: data = 0; break;
+        }
+        shift_in(state, data, bit_count);
+
+        if (config->autopush && state->isr_count >= config->push_threshold && state->rx.level < state->rx.depth)
+        {
+            push_isr(state);
+        }
+        return true;
+    }
+
+    case OP_OUT:
+    {
+        if (config->autopull && osr_empty(state))
+        {
+            uint32_t data;
+            if (!fifo_pop(&state->tx, &data))
+            {
+                return false;
+            }
+            pull_osr(state, data);
+        }
+
+        const uint32_t data = shift_out(state, bit_count);
+        switch (arg1)
+        {
+        case 0: write_pins(&sim->pins, config->out_base, config->out_count < bit_count ? config->out_count : bit_count, data); break;
+        case 1: state->x = data; break;
+        case 2: state->y = data; break;
+        case 4: write_pins(&sim->pindirs, config->out_base, config->out_count < bit_count ? config->out_count : bit_count, data); break;
+        case 5: *next_pc = data & 0x1f; break;
+        case 6:
+            state->isr = data;
+            state->isr_count = bit_count;
+            break;
+        case 7:
+            state->exec_pending = true;
+            state->exec_instruction = data;
+            break;
+        default: break;
+        }
+
+        // The OSR is refilled in the background as soon as it's empty.
+        if (config->autopull && osr_empty(state))
+        {
+            uint32_t refill;
+            if (fifo_pop(&state->tx, &refill))
+            {
+                pull_osr(state, refill);
+            }
+        }
+        return true;
+    }
+
+    case OP_PUSH_PULL:
+    {
+        const bool if_flag = (instruction >> 6) & 1;
+        const bool block = (instruction >> 5) & 1;
+
+        if (instruction & 0x80)
+        {
+            // PULL
+            if (if_flag && !osr_empty(state))
+            {
+                return true;
+            }
+            uint32_t data;
+            if (fifo_pop(&state->tx, &data))
+            {
+                pull_osr(state, data);
+                return true;
+            }
+            if (block)
+            {
+                return false;
+            }
+            pull_osr(state, state->x);
+            return true;
+        }
+
+        // PUSH
+        if (if_flag && state->isr_count < config->push_threshold)
+        {
+            return true;
+        }
+        if (state->rx.level == state->rx.depth)
+        {
+            return !block;
+        }
+        push_isr(state);
+        return true;
+    }
+
+    case OP_MOV:
+    {
+        uint32_t data;
+        switch (instruction & 7)
+        {
+        case 0: data = read_pins(sim, config->in_base); break;
+        case 1: data = state->x; break;
+        case 2: data = state->y; break;
+        case 5: data = 0; break; // STATUS, without a status_sel in the config it reads all zeros.
+        case 6: data = state->isr; break;
+        case 7: data = state->osr; break;
+        default: data = 0; break;
+        }
+
+        const unsigned operation = (instruction >> 3) & 3;
+        if (operation == 1)
+        {
+            data = ~data;
+        }
+        else if (operation == 2)
+        {
+            data = reverse_bits(data);
+        }
+
+        switch (arg1)
+        {
+        case 0: write_pins(&sim->pins, config->out_base, config->out_count, data); break;
+        case 1: state->x = data; break;
+        case 2: state->y = data; break;
+        case 4:
+            state->exec_pending = true;
+            state->exec_instruction = data;
+            break;
+        case 5: *next_pc = data & 0x1f; break;
+        case 6:
+            state->isr = data;
+            state->isr_count = 0;
+            break;
+        case 7:
+            state->osr = data;
+            state->osr_count = 0;
+            break;
+        default: break;
+        }
+        return true;
+    }
+
+    case OP_IRQ:
+    {
+        const unsigned index = irq_index(sm, arg2);
+        if (instruction & 0x40)
+        {
+            irq_clear(sim, index);
+            return true;
+        }
+        if (instruction & 0x20)
+        {
+            // IRQ WAIT: set the flag once, then stall until somebody clears it.
+            if (!state->irq_waiting)
+            {
+                irq_set(sim, index);
+                state->irq_waiting = true;
+                return false;
+            }
+            if (irq_get(sim, index))
+            {
+                return false;
+            }
+            state->irq_waiting = false;
+            return true;
+        }
+        irq_set(sim, index);
+        return true;
+    }
+
+    default:
+    {
+        switch (arg1)
+        {
+        case 0: write_pins(&sim->pins, config->set_base, config->set_count, arg2); break;
+        case 1: state->x = arg2; break;
+        case 2: state->y = arg2; break;
+        case 4: write_pins(&sim->pindirs, config->set_base, config->set_count, arg2); break;
+        default: break;
+        }
+        return true;
+    }
+    }
+}
+
+static void run_cycle(struct pio_sim_t* sim, unsigned sm)
+{
+    struct pio_sim_sm_t* state = &sim->sm[sm];
+    const struct pio_sim_config_t* config = &state->config;
+
+    state->cycles++;
+
+    if (state->delay)
+    {
+        state->delay--;
+        return;
+    }
+
+    const bool from_exec = state->exec_pending;
+    const uint16_t instruction = from_exec ? state->exec_instruction : sim->instructions[state->pc];
+    state->exec_pending = false;
+
+    // Delay and side-set share 5 bits, side-set is applied even if the instruction stalls.
+    const unsigned delay_bits = 5 - config->sideset_count;
+    const unsigned field = (instruction >> 8) & 0x1f;
+    if (config->sideset_count)
+    {
+        const unsigned sideset = field >> delay_bits;
+        const unsigned value_bits = config->sideset_count - (config->sideset_opt ? 1 : 0);
+        if (!config->sideset_opt || (sideset >> value_bits))
+        {
+            write_pins(config->sideset_pindirs ? &sim->pindirs : &sim->pins, config->sideset_base, value_bits, sideset);
+        }
+    }
+
+    // Wrap only applies to instructions fetched from the memory.
+    uint8_t next_pc = from_exec ? state->pc : ((state->pc == config->wrap) ? config->wrap_target : (state->pc + 1) & 31);
+    if (!execute(sim, sm, instruction, &next_pc))
+    {
+        state->stalled_cycles++;
+        if (from_exec)
+        {
+            // A stalled EXEC'd instruction is retried.
+            state->exec_pending = true;
+        }
+        return;
+    }
+
+    state->pc = next_pc;
+    state->delay = field & ((1u << delay_bits) - 1);
+}
+
+void pio_sim_step(struct pio_sim_t* sim)
+{
+    for (unsigned sm = 0; sm < PIO_SM_COUNT; sm++)
+    {
+        struct pio_sim_sm_t* state = &sim->sm[sm];
+        if (!state->enabled)
+        {
+            continue;
+        }
+
+        state->clock_acc += 256;
+        const uint32_t div = divider_256(&state->config);
+        if (state->clock_acc >= div)
+        {
+            state->clock_acc -= div;
+            run_cycle(sim, sm);
+        }
+    }
+
+    for (unsigned i = 0; i < PIO_IRQ_COUNT; i++)
+    {
+        if ((sim->irq_set >> i) & 1 & ~(sim->irq >> i))
+        {
+            sim->irq_raised[i]++;
+        }
+    }
+    sim->irq = (sim->irq | sim->irq_set) & ~(sim->irq_clear & ~sim->irq_set);
+    sim->irq_set = 0;
+    sim->irq_clear = 0;
+    sim->time++;
+}
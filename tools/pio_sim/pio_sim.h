@@ -0,0 +1,136 @@
+/**
+ * Cycle accurate simulator of one PIO block, for running the .pio programs on the host.
+ *
+ * Models the 32 instruction memory shared by the four state machines, the clock dividers
+ * (integer and fractional), the FIFOs (joined or not), the shift registers with autopull and
+ * autopush, delays, side-set, wrap and the 8 irq flags. Instructions are executed exactly as
+ * the hardware does, the same machine code pioasm produces, so delays and stalls can be
+ * measured to the system clock cycle.
+ *
+ * The configuration mirrors pio_sm_config of the SDK so the _program_init() functions of the
+ * .pio files can be ported line by line.
+ */
+#ifndef PIO_SIM_H
+#define PIO_SIM_H
+
+#include "pio_asm.h"
+
+#define PIO_SM_COUNT 4
+#define PIO_FIFO_DEPTH 4
+#define PIO_IRQ_COUNT 8
+
+struct pio_sim_config_t
+{
+    uint8_t out_base;
+    uint8_t out_count;
+    uint8_t set_base;
+    uint8_t set_count;
+    uint8_t in_base;
+    uint8_t sideset_base;
+    uint8_t sideset_count; // Including the enable bit when optional.
+    bool sideset_opt;
+    bool sideset_pindirs;
+    uint8_t jmp_pin;
+
+    uint8_t wrap_target; // Absolute addresses in the instruction memory.
+    uint8_t wrap;
+
+    bool out_shift_right;
+    bool autopull;
+    uint8_t pull_threshold; // 1 to 32.
+    bool in_shift_right;
+    bool autopush;
+    uint8_t push_threshold;
+
+    bool join_tx; // 8 entries TX FIFO, no RX one.
+    bool join_rx;
+
+    uint16_t clkdiv_int;
+    uint8_t clkdiv_frac;
+};
+
+struct pio_sim_fifo_t
+{
+    uint32_t data[PIO_FIFO_DEPTH * 2];
+    unsigned head;
+    unsigned level;
+    unsigned depth;
+};
+
+struct pio_sim_sm_t
+{
+    struct pio_sim_config_t config;
+    bool enabled;
+
+    uint8_t pc;
+    uint32_t x;
+    uint32_t y;
+    uint32_t isr;
+    uint32_t osr;
+    uint8_t isr_count; // Bits shifted in.
+    uint8_t osr_count; // Bits shifted out, 32 is empty.
+    unsigned delay;	   // Delay cycles left of the last instruction.
+
+    bool exec_pending; // OUT/MOV EXEC, executed on the next cycle.
+    uint16_t exec_instruction;
+    bool irq_waiting; // IRQ WAIT set its flag, now waiting for it to be cleared.
+
+    struct pio_sim_fifo_t tx;
+    struct pio_sim_fifo_t rx;
+
+    uint32_t clock_acc; // Fractional divider, 1/256 of a system clock.
+
+    // Statistics.
+    uint64_t cycles;		 // SM clock cycles run.
+    uint64_t stalled_cycles; // Cycles spent stalled on an instruction.
+};
+
+struct pio_sim_t
+{
+    uint16_t instructions[PIO_INSTRUCTION_COUNT];
+    uint32_t used_mask;
+
+    struct pio_sim_sm_t sm[PIO_SM_COUNT];
+
+    uint8_t irq;		  // The 8 irq flags.
+    uint8_t irq_set;	  // Changes made during the current cycle, applied at its end.
+    uint8_t irq_clear;
+    uint64_t irq_raised[PIO_IRQ_COUNT]; // Times each flag went from 0 to 1.
+
+    uint32_t pins; // Output levels.
+    uint32_t pindirs;
+    uint32_t pins_in; // Levels read by the state machines for pins not driven by the PIO.
+
+    uint64_t time; // System clock cycles since pio_sim_init().
+};
+
+void pio_sim_init(struct pio_sim_t* sim);
+
+// Load a program at the highest free offset, like pio_add_program(). JMPs are relocated.
+// Returns the offset or -1 if it doesn't fit.
+int pio_sim_add_program(struct pio_sim_t* sim, const struct pio_program_t* program);
+
+// Same as <program>_program_get_default_config(): wrap and side-set of the program, shift right, clkdiv 1.
+struct pio_sim_config_t pio_sim_get_default_config(const struct pio_program_t* program, unsigned offset);
+
+// Clock divider as sm_config_set_clkdiv(), from a float.
+void pio_sim_config_set_clkdiv(struct pio_sim_config_t* config, float div);
+
+// Reset the state machine with the given configuration and jump to initial_pc, like pio_sm_init().
+void pio_sim_sm_init(struct pio_sim_t* sim, unsigned sm, unsigned initial_pc, const struct pio_sim_config_t* config);
+
+// Enable the state machines of the mask with their clock dividers in phase, like pio_enable_sm_mask_in_sync().
+void pio_sim_enable_sm_mask_in_sync(struct pio_sim_t* sim, uint32_t mask);
+
+// Push a word into the TX FIFO, false if full.
+bool pio_sim_put(struct pio_sim_t* sim, unsigned sm, uint32_t data);
+
+// Pop a word from the RX FIFO, false if empty.
+bool pio_sim_get(struct pio_sim_t* sim, unsigned sm, uint32_t* data);
+
+unsigned pio_sim_get_tx_level(const struct pio_sim_t* sim, unsigned sm);
+
+// Run one system clock cycle.
+void pio_sim_step(struct pio_sim_t* sim);
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * PNG writer, see png.h.
+ */
+#include "png.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Largest stored deflate block.
+#define STORED_BLOCK_MAX 65535
+
+static uint32_t s_crc_table[256];
+
+static void make_crc_table(void)
+{
+    for (uint32_t n = 0; n < 256; n++)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+        {
+            c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        s_crc_table[n] = c;
+    }
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = s_crc_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static void put_u32(uint8_t* out, uint32_t value)
+{
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+static void write_chunk(FILE* file, const char* type, const uint8_t* data, uint32_t length)
+{
+    uint8_t header[8];
+    put_u32(header, length);
+    memcpy(header + 4, type, 4);
+    fwrite(header, 1, 8, file);
+    if (length > 0)
+    {
+        fwrite(data, 1, length, file); // IEND has no data, and no pointer.
+    }
+
+    uint32_t crc = crc32_update(0xffffffffu, (const uint8_t*)type, 4);
+    crc = crc32_update(crc, data, length) ^ 0xffffffffu;
+    uint8_t trailer[4];
+    put_u32(trailer, crc);
+    fwrite(trailer, 1, 4, file);
+}
+
+bool png_write_rgb(const char* path, const uint8_t* rgb, unsigned width, unsigned height)
+{
+    make_crc_table();
+
+    // Raw image: each row starts with filter type 0 (none).
+    const size_t row_bytes = (size_t)width * 3 + 1;
+    const size_t raw_size = row_bytes * height;
+    uint8_t* raw = malloc(raw_size);
+
+    // zlib stream: 2 byte header, stored blocks of 5 byte header each, adler32.
+    const size_t blocks = raw_size / STORED_BLOCK_MAX + 1;
+    uint8_t* zlib = malloc(2 + blocks * 5 + raw_size + 4);
+    if (!raw || !zlib)
+    {
+        free(raw);
+        free(zlib);
+        return false;
+    }
+
+    for (unsigned y = 0; y < height; y++)
+    {
+        raw[y * row_bytes] = 0;
+        memcpy(raw + y * row_bytes + 1, rgb + (size_t)y * width * 3, (size_t)width * 3);
+    }
+
+    size_t size = 0;
+    zlib[size++] = 0x78; // Deflate, 32K window.
+    zlib[size++] = 0x01; // No preset dictionary, header check bits.
+    size_t offset = 0;
+    do
+    {
+        const size_t length = (raw_size - offset > STORED_BLOCK_MAX) ? STORED_BLOCK_MAX : raw_size - offset;
+        zlib[size++] = (offset + length == raw_size) ? 1 : 0; // BFINAL, BTYPE 00.
+        zlib[size++] = length & 0xff;
+        zlib[size++] = length >> 8;
+        zlib[size++] = ~length & 0xff;
+        zlib[size++] = (~length >> 8) & 0xff;
+        memcpy(zlib + size, raw + offset, length);
+        size += length;
+        offset += length;
+    } while (offset < raw_size);
+
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (size_t i = 0; i < raw_size; i++)
+    {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    put_u32(zlib + size, (b << 16) | a);
+    size += 4;
+
+    bool ok = false;
+    FILE* file = fopen(path, "wb");
+    if (file)
+    {
+        static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        fwrite(signature, 1, sizeof(signature), file);
+
+        uint8_t ihdr[13];
+        put_u32(ihdr, width);
+        put_u32(ihdr + 4, height);
+        ihdr[8] = 8;  // Bit depth.
+        ihdr[9] = 2;  // Truecolour.
+        ihdr[10] = 0; // Deflate.
+        ihdr[11] = 0; // Adaptive filtering.
+        ihdr[12] = 0; // No interlace.
+        write_chunk(file, "IHDR", ihdr, sizeof(ihdr));
+        write_chunk(file, "IDAT", zlib, size);
+        write_chunk(file, "IEND", NULL, 0);
+        ok = !ferror(file);
+        fclose(file);
+    }
+
+    free(raw);
+    free(zlib);
+    return ok;
+}
@@ -0,0 +1,13 @@
+/**
+ * Tiny PNG writer: 8-bit RGB, stored (uncompressed) deflate blocks, no dependencies.
+ */
+#ifndef PNG_H
+#define PNG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// rgb has 3 bytes per pixel, rows one after the other.
+bool png_write_rgb(const char* path, const uint8_t* rgb, unsigned width, unsigned height);
+
+#endif
@@ -0,0 +1,285 @@
+/**
+ * Timing check, see timing_check.h.
+ */
+#include "timing_check.h"
+
+#include <math.h>
+#include <string.h>
+
+// What the sync table gives, the csync divider is fractional so a tic can be a system clock cycle longer.
+#define TIC_TOLERANCE_US 0.01
+#define PERIOD_TOLERANCE_US 0.1
+
+// Front porch 1.65 +0.4 / -0.1 us, line blanking 12.05 us: back porch 5.7 us.
+const struct timing_standard_t timing_standard_pal = {"PAL", 64.0, 4.7, 0.2, 27.3, 0.1, 2.35, 0.1, 1.55, 5.7, 12.05};
+
+// The vertical sync pulses are half a line less their 4.7 us serration. Front porch 1.5 +-0.1 us, line blanking
+// 10.9 us.
+const struct timing_standard_t timing_standard_ntsc = {"NTSC", 63.556, 4.7, 0.1, 27.1, 0.1, 2.3, 0.1, 1.4, 4.7, 10.9};
+
+// How far off the centre of the active line the picture may be, 3% of it, well inside the overscan of a TV.
+#define CENTRE_TOLERANCE_US 1.5
+
+// Pulses longer than this are broad ones, shorter than HSYNC_MIN_US are equalising ones.
+#define BROAD_MIN_US 15.0
+#define HSYNC_MIN_US 3.5
+
+static void set_limits(struct timing_check_t* check, enum timing_measure_id_t id, const char* name, double min_limit, double max_limit)
+{
+    struct timing_measure_t* measure = &check->measures[id];
+    measure->name = name;
+    measure->min_limit = min_limit;
+    measure->max_limit = max_limit;
+}
+
+// The standard gives nominal +- tolerance, widened to the allowance of the mode if it has one.
+static void set_pulse(struct timing_check_t* check, enum timing_measure_id_t id, const char* name, double nominal, double tolerance,
+                      const struct timing_allowance_t* allowance)
+{
+    const double min = nominal - tolerance;
+    const double max = nominal + tolerance;
+    set_limits(check, id, name, allowance ? fmin(min, allowance->min_us) : min, allowance ? fmax(max, allowance->max_us) : max);
+    struct timing_measure_t* measure = &check->measures[id];
+    measure->has_standard = true;
+    measure->standard_min = min;
+    measure->standard_max = max;
+}
+
+void timing_check_init(struct timing_check_t* check, const struct timing_check_config_t* config)
+{
+    memset(check, 0, sizeof(*check));
+
+    const double line_us = config->line_us;
+    check->line_us = line_us;
+    check->half_line_us = line_us / 2;
+    check->irq_delay_us = config->irq_us;
+    check->rgb_cycle_us = 1e6 / config->rgb_clock_hz;
+    check->active_us = config->res_x * 3 * check->rgb_cycle_us;
+
+    const struct timing_standard_t* standard = config->standard;
+    check->standard = standard;
+    set_pulse(check, TIMING_HSYNC_WIDTH, "hsync width", standard->hsync_us, standard->hsync_tolerance_us, config->hsync);
+    set_pulse(check, TIMING_BROAD_WIDTH, "broad pulse width", standard->broad_us, standard->broad_tolerance_us, config->broad);
+    set_pulse(check, TIMING_EQUALISING_WIDTH, "equalising pulse width", standard->equalising_us, standard->equalising_tolerance_us,
+              config->equalising);
+    set_limits(check, TIMING_LINE_PERIOD, "line period", line_us - TIC_TOLERANCE_US, line_us + TIC_TOLERANCE_US);
+    set_limits(check, TIMING_HALF_LINE_GRID, "off the half line grid", -TIC_TOLERANCE_US, TIC_TOLERANCE_US);
+
+    // Progressive: every field has the same whole number of lines and starts on a line. Interlaced: half a
+    // line more, the first hsync comes half a line later every other field.
+    const double lines_per_field = config->lines_per_field;
+    const bool interlaced = lines_per_field != floor(lines_per_field);
+    const double field_us = lines_per_field * line_us;
+    const double first_line_us = config->first_line_lines * line_us;
+    set_limits(check, TIMING_FIELD_PERIOD, "field period", field_us - PERIOD_TOLERANCE_US, field_us + PERIOD_TOLERANCE_US);
+    set_limits(check, TIMING_LINES_PER_FIELD, "lines per field", lines_per_field, lines_per_field);
+    set_limits(check, TIMING_BROAD_PER_FIELD, "broad pulses per field", config->broad_pulses, config->broad_pulses);
+    set_limits(check, TIMING_ACTIVE_LINES_PER_FIELD, "active lines per field", config->min_active_lines, config->max_active_lines);
+    set_limits(check, TIMING_FIRST_LINE, "first hsync after vsync", first_line_us - PERIOD_TOLERANCE_US,
+               first_line_us + (interlaced ? check->half_line_us : 0) + PERIOD_TOLERANCE_US);
+    const double offset = interlaced ? check->half_line_us : 0;
+    set_limits(check, TIMING_FIELD_OFFSET, "field to field offset", offset - PERIOD_TOLERANCE_US, offset + PERIOD_TOLERANCE_US);
+
+    // The rgb state machine waits for irq 0 and outputs the first pixel within a few of its cycles, RES_X pixels of
+    // 3 cycles, none lost. Around them at least the porches of the standard, the rest of its active line is black
+    // and shared between both sides, give or take CENTRE_TOLERANCE_US.
+    const double margin = (line_us - standard->line_blanking_us - check->active_us) / 2 + CENTRE_TOLERANCE_US;
+    set_limits(check, TIMING_IRQ_DELAY, "irq 0 after hsync", check->irq_delay_us - TIC_TOLERANCE_US, check->irq_delay_us + TIC_TOLERANCE_US);
+    set_limits(check, TIMING_BACK_PORCH, "back porch", standard->back_porch_us, standard->back_porch_us + margin);
+    set_limits(check, TIMING_RGB_LATENCY, "first pixel after irq 0", 0.0, 3 * check->rgb_cycle_us + 0.01);
+    set_limits(check, TIMING_ACTIVE_WIDTH, "active video", check->active_us - 0.01, check->active_us + check->rgb_cycle_us);
+    set_limits(check, TIMING_FRONT_PORCH, "front porch", standard->front_porch_us, standard->front_porch_us + margin);
+    set_limits(check, TIMING_RGB_IN_SYNC, "pixels in blanking lines", 0, 0);
+}
+
+static void record(struct timing_check_t* check, enum timing_measure_id_t id, double value)
+{
+    if (!check->started)
+    {
+        return;
+    }
+
+    struct timing_measure_t* measure = &check->measures[id];
+    if (measure->count == 0 || value < measure->min)
+    {
+        measure->min = value;
+    }
+    if (measure->count == 0 || value > measure->max)
+    {
+        measure->max = value;
+    }
+    measure->count++;
+    if (value < measure->min_limit || value > measure->max_limit)
+    {
+        measure->failures++;
+    }
+    if (measure->has_standard && (value < measure->standard_min || value > measure->standard_max))
+    {
+        measure->off_standard++;
+    }
+}
+
+// A new sync pulse starts at next_fall, close the active video of the line before it.
+static void finish_line(struct timing_check_t* check, double next_fall)
+{
+    if (check->line_has_irq)
+    {
+        check->active_lines++;
+        const bool ended = check->rgb_active && check->rgb == 0;
+        record(check, TIMING_ACTIVE_WIDTH, ended ? check->rgb_end - check->rgb_start : 0);
+        record(check, TIMING_FRONT_PORCH, ended ? next_fall - check->rgb_end : 0);
+    }
+    else
+    {
+        record(check, TIMING_RGB_IN_SYNC, check->rgb_active ? 1 : 0);
+    }
+
+    check->line_has_irq = false;
+    check->rgb_active = check->rgb != 0;
+}
+
+static enum timing_pulse_t classify(double width)
+{
+    if (width > BROAD_MIN_US)
+    {
+        return TIMING_PULSE_BROAD;
+    }
+    return (width > HSYNC_MIN_US) ? TIMING_PULSE_HSYNC : TIMING_PULSE_EQUALISING;
+}
+
+void timing_check_csync(struct timing_check_t* check, double time_us, bool level)
+{
+    if (level == !check->csync_low)
+    {
+        return;
+    }
+    check->csync_low = !level;
+
+    if (!level)
+    {
+        check->fall = time_us;
+        finish_line(check, time_us);
+        return;
+    }
+
+    check->rise = time_us;
+    const double width = time_us - check->fall;
+    const enum timing_pulse_t pulse = classify(width);
+
+    // A field begins with the first broad pulse.
+    if (pulse == TIMING_PULSE_BROAD && check->last_pulse != TIMING_PULSE_BROAD)
+    {
+        if (check->started)
+        {
+            const double field_us = check->fall - check->field_start;
+            record(check, TIMING_FIELD_PERIOD, field_us);
+            record(check, TIMING_LINES_PER_FIELD, round(field_us / check->half_line_us) / 2);
+            record(check, TIMING_BROAD_PER_FIELD, check->broad);
+            record(check, TIMING_ACTIVE_LINES_PER_FIELD, check->active_lines);
+            check->fields++;
+        }
+        check->started = true;
+        check->field_start = check->fall;
+        check->broad = 0;
+        check->active_lines = 0;
+        check->first_line_seen = false;
+    }
+
+    switch (pulse)
+    {
+    case TIMING_PULSE_BROAD:
+        check->broad++;
+        record(check, TIMING_BROAD_WIDTH, width);
+        break;
+    case TIMING_PULSE_HSYNC:
+        record(check, TIMING_HSYNC_WIDTH, width);
+        if (!check->first_line_seen)
+        {
+            const double first_line = check->fall - check->field_start;
+            record(check, TIMING_FIRST_LINE, first_line);
+            if (check->has_first_line)
+            {
+                record(check, TIMING_FIELD_OFFSET, fabs(first_line - check->first_line));
+            }
+            check->first_line = first_line;
+            check->first_line_seen = true;
+            check->has_first_line = check->started;
+        }
+        break;
+    default: record(check, TIMING_EQUALISING_WIDTH, width); break;
+    }
+
+    // Lines are 64 us, the vertical sync pulses come every half line and the half lines of
+    // interlaced are in between, all of them on the same grid.
+    if (check->last_pulse != TIMING_PULSE_NONE)
+    {
+        const double period = check->fall - check->last_fall;
+        if (check->last_pulse == TIMING_PULSE_HSYNC && pulse == TIMING_PULSE_HSYNC)
+        {
+            record(check, TIMING_LINE_PERIOD, period);
+        }
+        else
+        {
+            record(check, TIMING_HALF_LINE_GRID, period - round(period / check->half_line_us) * check->half_line_us);
+        }
+    }
+    check->last_pulse = pulse;
+    check->last_fall = check->fall;
+}
+
+void timing_check_rgb(struct timing_check_t* check, double time_us, unsigned rgb)
+{
+    if (rgb && !check->rgb_active)
+    {
+        check->rgb_active = true;
+        check->rgb_start = time_us;
+        if (check->line_has_irq)
+        {
+            record(check, TIMING_RGB_LATENCY, time_us - check->irq);
+            record(check, TIMING_BACK_PORCH, time_us - check->rise);
+        }
+    }
+    else if (!rgb)
+    {
+        check->rgb_end = time_us;
+    }
+    check->rgb = rgb;
+}
+
+void timing_check_irq(struct timing_check_t* check, double time_us)
+{
+    check->line_has_irq = true;
+    check->irq = time_us;
+    record(check, TIMING_IRQ_DELAY, time_us - check->fall);
+}
+
+bool timing_check_report(const struct timing_check_t* check, FILE* file)
+{
+    bool pass = check->started;
+    if (!check->started)
+    {
+        fprintf(file, "no complete field\n");
+    }
+
+    fprintf(file, "%u fields measured, %s\n", check->fields, check->standard->name);
+    for (unsigned i = 0; i < TIMING_MEASURE_COUNT; i++)
+    {
+        const struct timing_measure_t* measure = &check->measures[i];
+        // A check that never ran is a failure too, something didn't happen at all.
+        const bool ok = measure->count > 0 && measure->failures == 0;
+        const char* status = ok ? "ok" : "FAIL";
+        fprintf(file, "%-26s %6u  %10.3f .. %-10.3f [%.3f, %.3f]  %s", measure->name, measure->count, measure->min, measure->max,
+                measure->min_limit, measure->max_limit, status);
+        if (measure->has_standard)
+        {
+            // The measure furthest from the nominal value.
+            const double nominal = (measure->standard_min + measure->standard_max) / 2;
+            const double deviation = fabs(measure->min - nominal) > fabs(measure->max - nominal) ? measure->min - nominal : measure->max - nominal;
+            fprintf(file, "%*s  %s %.2f +-%.2f: %+.3f%s", (int)(4 - strlen(status)), "", check->standard->name, nominal,
+                    (measure->standard_max - measure->standard_min) / 2, deviation, measure->off_standard ? " outside, allowed" : "");
+        }
+        fprintf(file, "\n");
+        pass = pass && ok;
+    }
+    return pass;
+}
@@ -0,0 +1,160 @@
+/**
+ * Timing check of the simulated csync and rgb pins.
+ *
+ * Fed with the pin changes and the irq 0 of csync, it measures every sync pulse, line
+ * period, field length and active video window. The sync pulses have to be within the nominal
+ * value and tolerance of PAL or NTSC, the periods what the sync table asks for to a hundredth of
+ * a microsecond, and the pixels inside the active line of the standard: the porches at least
+ * those of the standard and at most that plus the black the picture leaves on its side of the
+ * active line, give or take CENTRE_TOLERANCE_US (1.5 us), so an off-centre picture fails.
+ *
+ * The pulses of this design are deliberately not those of the standard (5 us hsync, 30 us
+ * broad pulses, 2 us equalising pulses, every TV tried locks to them). Each mode states how
+ * far off it goes in a timing_allowance_t, accepted up to that bound and no further, and the
+ * distance to the standard is reported next to them.
+ */
+#ifndef TIMING_CHECK_H
+#define TIMING_CHECK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Nominal values and tolerances of a standard, us.
+struct timing_standard_t
+{
+    const char* name;
+    double line_us;
+    double hsync_us;
+    double hsync_tolerance_us;
+    double broad_us;
+    double broad_tolerance_us;
+    double equalising_us;
+    double equalising_tolerance_us;
+    double front_porch_us;	 // Minimum blanking from the last pixel to the hsync falling edge.
+    double back_porch_us;	 // Minimum blanking from the hsync rising edge to the first pixel.
+    double line_blanking_us; // Nominal, the rest of the line is the active line.
+};
+
+// Range a pulse of a mode is accepted in instead of the nominal value +- tolerance of the standard, which it widens.
+struct timing_allowance_t
+{
+    double min_us;
+    double max_us;
+};
+
+extern const struct timing_standard_t timing_standard_pal;	// ITU-R BT.470, 625 lines.
+extern const struct timing_standard_t timing_standard_ntsc; // SMPTE 170M, 525 lines.
+
+struct timing_measure_t
+{
+    const char* name;
+    double min_limit; // Accepted range, us.
+    double max_limit;
+    double min;		  // Measured range.
+    double max;
+    unsigned count;
+    unsigned failures;
+
+    // Range of the standard for the measures that have one, the limits are wider where a mode has an allowance.
+    bool has_standard;
+    double standard_min;
+    double standard_max;
+    unsigned off_standard;
+};
+
+enum timing_measure_id_t
+{
+    TIMING_HSYNC_WIDTH,
+    TIMING_BROAD_WIDTH,
+    TIMING_EQUALISING_WIDTH,
+    TIMING_LINE_PERIOD,
+    TIMING_HALF_LINE_GRID, // Distance of the other pulses to the half line grid.
+    TIMING_FIELD_PERIOD,
+    TIMING_LINES_PER_FIELD,
+    TIMING_BROAD_PER_FIELD,
+    TIMING_ACTIVE_LINES_PER_FIELD,
+    TIMING_FIRST_LINE,	 // From the first broad pulse to the first hsync.
+    TIMING_FIELD_OFFSET, // Change of TIMING_FIRST_LINE from a field to the next, half a line when interlaced.
+    TIMING_IRQ_DELAY,
+    TIMING_BACK_PORCH,
+    TIMING_RGB_LATENCY,
+    TIMING_ACTIVE_WIDTH,
+    TIMING_FRONT_PORCH,
+    TIMING_RGB_IN_SYNC, // Pixels outside of the active window, must be 0.
+    TIMING_MEASURE_COUNT
+};
+
+enum timing_pulse_t
+{
+    TIMING_PULSE_NONE,
+    TIMING_PULSE_HSYNC,
+    TIMING_PULSE_BROAD,
+    TIMING_PULSE_EQUALISING,
+};
+
+// What the sync table and the programs are expected to do, and the standard they are checked against.
+struct timing_check_config_t
+{
+    const struct timing_standard_t* standard;
+    double line_us;
+    const struct timing_allowance_t* hsync; // Pulses of the sync table deliberately off the standard, NULL if not.
+    const struct timing_allowance_t* broad;
+    const struct timing_allowance_t* equalising;
+    double lines_per_field;	 // 312 / 262, plus half a line when interlaced.
+    unsigned broad_pulses;	 // Per field.
+    double first_line_lines; // From the first broad pulse to the first hsync, half a line more every other field when interlaced.
+    double irq_us;			 // From the hsync falling edge to irq 0.
+    unsigned res_x;			 // Pixels of 3 cycles of the rgb state machine at rgb_clock_hz.
+    double rgb_clock_hz;
+    unsigned min_active_lines; // Lines with irq 0 per field, the fields of interlaced may differ by one.
+    unsigned max_active_lines;
+};
+
+struct timing_check_t
+{
+    struct timing_measure_t measures[TIMING_MEASURE_COUNT];
+    const struct timing_standard_t* standard;
+
+    double line_us;
+    double half_line_us;
+    double irq_delay_us; // From the hsync falling edge to irq 0.
+    double active_us;	 // Duration of the pixels of a line.
+    double rgb_cycle_us; // One cycle of the rgb state machine.
+
+    // Sync state.
+    bool started; // Measuring begins at the first broad pulse.
+    bool csync_low;
+    double fall;
+    double rise;
+    enum timing_pulse_t last_pulse;
+    double last_fall;
+    double field_start;
+    bool first_line_seen;
+    double first_line;
+    bool has_first_line; // first_line of the previous field is valid.
+    unsigned broad;
+    unsigned active_lines;
+    unsigned fields; // Fields measured whole.
+
+    // Active video of the current line.
+    bool line_has_irq;
+    double irq;
+    bool rgb_active;
+    double rgb_start;
+    double rgb_end;
+    unsigned rgb;
+};
+
+// The state machines start from the top of the sync table with csync high: the first broad pulse begins the first
+// field measured. Again to measure from a restart.
+void timing_check_init(struct timing_check_t* check, const struct timing_check_config_t* config);
+
+void timing_check_csync(struct timing_check_t* check, double time_us, bool level);
+void timing_check_rgb(struct timing_check_t* check, double time_us, unsigned rgb);
+void timing_check_irq(struct timing_check_t* check, double time_us);
+
+// Print every measure with the standard next to it and return true if all of them are within their limits.
+bool timing_check_report(const struct timing_check_t* check, FILE* file);
+
+#endif
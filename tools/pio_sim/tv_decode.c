@@ -0,0 +1,110 @@
+/**
+ * Picture decoder, see tv_decode.h.
+ */
+#include "tv_decode.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// Same classification as timing_check.c.
+#define BROAD_MIN_US 15.0
+#define HSYNC_MIN_US 3.5
+
+bool tv_decode_init(struct tv_decode_t* tv, double pixel_us, double line_us, unsigned field_rows, unsigned fields, unsigned color_bits)
+{
+    *tv = (struct tv_decode_t){0};
+    tv->width = (unsigned)(TV_ACTIVE_US / pixel_us);
+    tv->field_rows = field_rows;
+    tv->fields = fields;
+    const unsigned height = field_rows * fields;
+    tv->height = height;
+    tv->pixel_us = pixel_us;
+    tv->line_us = line_us;
+    tv->color_bits = color_bits;
+    tv->rgb = calloc((size_t)tv->width * height, 3);
+    return tv->rgb != NULL;
+}
+
+void tv_decode_free(struct tv_decode_t* tv)
+{
+    free(tv->rgb);
+    tv->rgb = NULL;
+}
+
+static void field_done(struct tv_decode_t* tv)
+{
+    tv->fields_done |= 1u << tv->parity;
+    tv->done = tv->fields_done == (1u << tv->fields) - 1;
+}
+
+void tv_decode_sample(struct tv_decode_t* tv, double time_us, bool csync, unsigned rgb)
+{
+    if (tv->done)
+    {
+        return;
+    }
+
+    if (csync == tv->csync_low)
+    {
+        tv->csync_low = !csync;
+        if (!csync)
+        {
+            tv->fall = time_us;
+            tv->sampling = false;
+        }
+        else
+        {
+            const double width = time_us - tv->fall;
+            if (width > BROAD_MIN_US)
+            {
+                // Vertical sync, a field with rows is over.
+                if (tv->vsync_seen && tv->row > 0)
+                {
+                    field_done(tv);
+                }
+                if (!tv->vsync_seen || tv->row > 0)
+                {
+                    tv->vsync = tv->fall;
+                }
+                tv->vsync_seen = true;
+                tv->row = 0;
+            }
+            else if (width > HSYNC_MIN_US && tv->vsync_seen && tv->row < tv->field_rows)
+            {
+                if (tv->row == 0)
+                {
+                    // Half a line off the grid of the vertical sync: the lower field.
+                    const double offset = fmod(tv->fall - tv->vsync, tv->line_us);
+                    tv->parity = (tv->fields > 1 && offset > tv->line_us / 4 && offset < tv->line_us * 3 / 4) ? 1 : 0;
+                }
+                tv->sampling = true;
+                tv->column = 0;
+                tv->next_sample = tv->fall + TV_ACTIVE_START_US;
+                tv->row++;
+            }
+        }
+        return;
+    }
+
+    while (tv->sampling && time_us >= tv->next_sample)
+    {
+        const unsigned y = (tv->row - 1) * tv->fields + tv->parity;
+        uint8_t* pixel = tv->rgb + ((size_t)y * tv->width + tv->column) * 3;
+        const unsigned bits = tv->color_bits;
+        const unsigned max = (1u << bits) - 1;
+        for (unsigned c = 0; c < 3; c++)
+        {
+            pixel[c] = (uint8_t)(((rgb >> (c * bits)) & max) * 255 / max);
+        }
+
+        tv->next_sample += tv->pixel_us;
+        if (++tv->column == tv->width)
+        {
+            tv->sampling = false;
+            if (tv->row == tv->field_rows)
+            {
+                field_done(tv);
+            }
+        }
+    }
+}
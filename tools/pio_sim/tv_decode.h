@@ -0,0 +1,51 @@
+/**
+ * Rebuild the picture a TV would show from the simulated csync and rgb pins.
+ *
+ * Each line starting with an hsync is sampled over the 52 us a TV shows, from 10.5 us after
+ * the falling edge, one sample per pixel period. The rows are the hsync lines of one field,
+ * counted from the vertical sync, so a change in the sync or pixel timing moves the picture
+ * just like on a screen. Colours are the rgb pins, color_bits per channel, red in the low bits.
+ *
+ * Interlaced, the two fields are woven: the field whose first hsync comes half a line later
+ * goes on the odd rows.
+ */
+#ifndef TV_DECODE_H
+#define TV_DECODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TV_ACTIVE_START_US 10.5
+#define TV_ACTIVE_US 52.0
+
+struct tv_decode_t
+{
+    unsigned width;
+    unsigned height; // Rows of the picture, field_rows * fields.
+    unsigned field_rows;
+    unsigned fields;
+    double pixel_us;
+    double line_us;
+    unsigned color_bits;
+    uint8_t* rgb; // width * height * 3 bytes.
+
+    bool csync_low;
+    double fall;
+    bool vsync_seen; // Rows are counted from the first broad pulse.
+    double vsync;
+    bool sampling;
+    unsigned row;
+    unsigned parity; // 1 for the field half a line lower.
+    unsigned fields_done; // Bit per parity.
+    unsigned column;
+    double next_sample;
+    bool done; // All the fields were decoded.
+};
+
+bool tv_decode_init(struct tv_decode_t* tv, double pixel_us, double line_us, unsigned field_rows, unsigned fields, unsigned color_bits);
+void tv_decode_free(struct tv_decode_t* tv);
+
+// Feed the pins at each step of the simulation.
+void tv_decode_sample(struct tv_decode_t* tv, double time_us, bool csync, unsigned rgb);
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * VCD writer, see vcd.h.
+ */
+#include "vcd.h"
+
+// One printable character per signal is enough for VCD_MAX_SIGNALS.
+#define IDENTIFIER(index) ((char)('!' + (index)))
+
+bool vcd_open(struct vcd_t* vcd, const char* path, const char* module, const struct vcd_signal_t* signals, unsigned count)
+{
+    if (count > VCD_MAX_SIGNALS)
+    {
+        return false;
+    }
+
+    vcd->file = fopen(path, "w");
+    if (!vcd->file)
+    {
+        return false;
+    }
+    vcd->count = count;
+    vcd->dumped = false;
+    vcd->last_time = 0;
+
+    fprintf(vcd->file, "$timescale 1ns $end\n");
+    fprintf(vcd->file, "$scope module %s $end\n", module);
+    for (unsigned i = 0; i < count; i++)
+    {
+        vcd->widths[i] = signals[i].width;
+        fprintf(vcd->file, "$var wire %u %c %s $end\n", signals[i].width, IDENTIFIER(i), signals[i].name);
+    }
+    fprintf(vcd->file, "$upscope $end\n$enddefinitions $end\n");
+    return true;
+}
+
+static void write_value(struct vcd_t* vcd, unsigned index, uint32_t value)
+{
+    if (vcd->widths[index] == 1)
+    {
+        fprintf(vcd->file, "%u%c\n", value & 1, IDENTIFIER(index));
+        return;
+    }
+
+    fputc('b', vcd->file);
+    for (int bit = vcd->widths[index] - 1; bit >= 0; bit--)
+    {
+        fputc('0' + ((value >> bit) & 1), vcd->file);
+    }
+    fprintf(vcd->file, " %c\n", IDENTIFIER(index));
+}
+
+void vcd_sample(struct vcd_t* vcd, uint64_t time_ns, const uint32_t* values)
+{
+    if (!vcd->dumped)
+    {
+        fprintf(vcd->file, "#%llu\n$dumpvars\n", (unsigned long long)time_ns);
+        for (unsigned i = 0; i < vcd->count; i++)
+        {
+            vcd->values[i] = values[i];
+            write_value(vcd, i, values[i]);
+        }
+        fprintf(vcd->file, "$end\n");
+        vcd->dumped = true;
+        vcd->last_time = time_ns;
+        return;
+    }
+
+    bool time_written = false;
+    for (unsigned i = 0; i < vcd->count; i++)
+    {
+        if (values[i] == vcd->values[i])
+        {
+            continue;
+        }
+        if (!time_written)
+        {
+            fprintf(vcd->file, "#%llu\n", (unsigned long long)time_ns);
+            time_written = true;
+        }
+        vcd->values[i] = values[i];
+        write_value(vcd, i, values[i]);
+    }
+    vcd->last_time = time_ns;
+}
+
+void vcd_close(struct vcd_t* vcd)
+{
+    if (vcd->file)
+    {
+        fprintf(vcd->file, "#%llu\n", (unsigned long long)vcd->last_time);
+        fclose(vcd->file);
+        vcd->file = NULL;
+    }
+}
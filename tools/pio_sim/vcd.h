@@ -0,0 +1,37 @@
+/**
+ * Value change dump writer, the waveform format GTKWave and most logic analyser software read.
+ */
+#ifndef VCD_H
+#define VCD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define VCD_MAX_SIGNALS 16
+
+struct vcd_signal_t
+{
+    const char* name;
+    unsigned width; // Bits.
+};
+
+struct vcd_t
+{
+    FILE* file;
+    unsigned count;
+    unsigned widths[VCD_MAX_SIGNALS];
+    uint32_t values[VCD_MAX_SIGNALS];
+    bool dumped; // Initial values written.
+    uint64_t last_time;
+};
+
+// Create the file and write the header, time in ns.
+bool vcd_open(struct vcd_t* vcd, const char* path, const char* module, const struct vcd_signal_t* signals, unsigned count);
+
+// Current values of all the signals, only the ones that changed are written.
+void vcd_sample(struct vcd_t* vcd, uint64_t time_ns, const uint32_t* values);
+
+void vcd_close(struct vcd_t* vcd);
+
+#endif
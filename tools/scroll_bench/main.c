@@ -0,0 +1,141 @@
+/**
+ * What scrolling the picture up a row costs: moving the pixels up with memmove, like a plain
+ * framebuffer has to, against the ring of framebuffer.c, where the display list of the field is
+ * built again (progressive, 4 blocks) or the read addresses of its line blocks are patched
+ * (interlaced or repeated rows, a block per line).
+ *
+ * Usage: scroll_bench [-n <scrolls>]
+ *
+ * The cycles are those of the Cortex-M0+ of the RP2040 from a model (see below), the host times
+ * follow. The ring side runs framebuffer.c itself on tools/sdk_stub: framebuffer_set_scroll() and
+ * the frame handler it runs from DMA_IRQ_0, with channel 1 at the top of the front list so that
+ * one list gets brought to the scroll, what each field costs. Neither side draws the row coming in.
+ * Built once per configuration (scroll_bench, scroll_bench_interlaced, scroll_bench_lowres).
+ */
+#include "dma_model.h"
+#include "framebuffer.h"
+#include "sdk_stub.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAME_BYTES (FRAME_Y * LINE_COUNT)
+
+// Cortex-M0+ from RAM, counted instruction by instruction and not measured, give or take a quarter. memmove: 16
+// bytes per ldm / stm pair of some 10 cycles. Ring: a list of 4 blocks built, 350 cycles with the calls and the
+// division of the ring row, or per line a multiply, the wrap test and the store of the read address, 14 cycles.
+#define MEMMOVE_CYCLES ((FRAME_BYTES - LINE_COUNT) * 10 / 16)
+#if VIDEO_INTERLACED || VIDEO_LINE_REPEAT > 1
+#define RING_CYCLES (30 + RES_Y * 14)
+#else
+#define RING_CYCLES 350
+#endif
+
+static const uint32_t s_border = 0;
+static volatile uint8_t s_sink; // Keeps the moves.
+
+void video_add_border_top(struct display_list_t* list)
+{
+    display_list_add_border(list, &s_border, 42);
+}
+
+void video_add_border_bottom(struct display_list_t* list, uint field)
+{
+    display_list_add_border(list, &s_border, 30 + field);
+}
+
+void video_set_list_builder(void (*build)(void))
+{
+    (void)build;
+}
+
+static bool sink_dreq(void* context)
+{
+    (void)context;
+    return true;
+}
+
+static void sink_write(void* context, uint32_t word)
+{
+    (void)context;
+    (void)word;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned scrolls = 20000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            scrolls = (unsigned)atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n <scrolls>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // memmove: the rows up by one.
+    uint8_t* pixels = malloc(FRAME_BYTES);
+    if (!pixels)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (unsigned i = 0; i < FRAME_BYTES; i++)
+    {
+        pixels[i] = (uint8_t)i;
+    }
+    double start = now_s();
+    for (unsigned i = 0; i < scrolls; i++)
+    {
+        memmove(pixels, pixels + LINE_COUNT, FRAME_BYTES - LINE_COUNT);
+    }
+    const double memmove_s = now_s() - start;
+    s_sink = pixels[FRAME_BYTES / 2];
+
+    // Ring: channel 1 has just loaded the top border of the front list of the first field.
+    display_list_init(pio0, 1, LINE_COUNT);
+    framebuffer_init();
+    struct dma_model_t dma;
+    dma_model_init(&dma, sink_dreq, sink_write, NULL);
+    display_list_start();
+    while (dma.lists == 0 || dma.reload)
+    {
+        dma_model_step(&dma);
+    }
+    start = now_s();
+    for (unsigned i = 0; i < scrolls; i++)
+    {
+        framebuffer_set_scroll(i + 1);
+        sdk_stub_irq(DMA_IRQ_0);
+    }
+    const double ring_s = now_s() - start;
+    if (framebuffer_scroll_pending())
+    {
+        fprintf(stderr, "the frame handler didn't take the scroll\n");
+        return 1;
+    }
+
+    // A scroll brings the list of each field to it.
+    const unsigned n = scrolls ? scrolls : 1;
+    printf("%ux%u, %u field(s), rows repeated %u times: memmove %u cycles (%u bytes), ring %u per field, memmove / ring %.1f;"
+           " host %.0f / %.0f ns\n",
+           RES_X, FRAME_Y, VIDEO_FIELDS, VIDEO_LINE_REPEAT, MEMMOVE_CYCLES, FRAME_BYTES - LINE_COUNT, RING_CYCLES,
+           (double)MEMMOVE_CYCLES / (RING_CYCLES * VIDEO_FIELDS), memmove_s * 1e9 / n, ring_s * 1e9 / n);
+
+    free(pixels);
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * DMA of the SDK on the host: the channel registers and the configuration calls, with the bits of the
+ * RP2040 CTRL register. Nothing moves by itself, tools/pio_sim/dma_model.h runs the channels.
+ *
+ * Addresses are host pointers, 32 bits on the chip: a control block is a struct control_block_t
+ * wherever it is copied, not 4 words.
+ */
+#ifndef HARDWARE_DMA_H
+#define HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+
+#define NUM_DMA_CHANNELS 12
+
+#define DMA_CH0_CTRL_TRIG_EN_BITS (1u << 0)
+#define DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB 2
+#define DMA_CH0_CTRL_TRIG_INCR_READ_BITS (1u << 4)
+#define DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS (1u << 5)
+#define DMA_CH0_CTRL_TRIG_RING_SIZE_LSB 6
+#define DMA_CH0_CTRL_TRIG_RING_SIZE_BITS (0xfu << 6)
+#define DMA_CH0_CTRL_TRIG_RING_SEL_BITS (1u << 10)
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB 11
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS (0xfu << 11)
+#define DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB 15
+#define DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS (0x3fu << 15)
+#define DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS (1u << 21)
+#define DMA_CH0_CTRL_TRIG_BUSY_BITS (1u << 24)
+
+#define DREQ_FORCE 0x3f
+
+enum dma_channel_transfer_size
+{
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2
+};
+
+typedef struct
+{
+    volatile uintptr_t read_addr;
+    volatile uintptr_t write_addr;
+    io_rw_32 transfer_count;
+    io_rw_32 al1_ctrl; // The CTRL register, BUSY included.
+    volatile uintptr_t al3_read_addr_trig;
+    uintptr_t ring_start; // Host only: where the read ring of the channel begins.
+} dma_channel_hw_t;
+
+typedef struct
+{
+    dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+    io_rw_32 ints0; // Write 1 to clear on the chip, the model clears it once the handler ran.
+    io_rw_32 inte0;
+} dma_hw_t;
+
+extern dma_hw_t sdk_stub_dma;
+#define dma_hw (&sdk_stub_dma)
+
+typedef struct
+{
+    uint32_t ctrl;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+
+// Read increment, no write increment, 32 bits, unpaced, chained to itself (nothing), irq not quiet.
+dma_channel_config dma_channel_get_default_config(uint channel);
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size)
+{
+    c->ctrl = (c->ctrl & ~(3u << DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB)) | ((uint32_t)size << DMA_CH0_CTRL_TRIG_DATA_SIZE_LSB);
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config* c, bool incr)
+{
+    c->ctrl = incr ? c->ctrl | DMA_CH0_CTRL_TRIG_INCR_READ_BITS : c->ctrl & ~DMA_CH0_CTRL_TRIG_INCR_READ_BITS;
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config* c, bool incr)
+{
+    c->ctrl = incr ? c->ctrl | DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS : c->ctrl & ~DMA_CH0_CTRL_TRIG_INCR_WRITE_BITS;
+}
+
+static inline void channel_config_set_dreq(dma_channel_config* c, uint dreq)
+{
+    c->ctrl = (c->ctrl & ~DMA_CH0_CTRL_TRIG_TREQ_SEL_BITS) | (dreq << DMA_CH0_CTRL_TRIG_TREQ_SEL_LSB);
+}
+
+static inline void channel_config_set_chain_to(dma_channel_config* c, uint chain_to)
+{
+    c->ctrl = (c->ctrl & ~DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS) | (chain_to << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB);
+}
+
+static inline void channel_config_set_irq_quiet(dma_channel_config* c, bool irq_quiet)
+{
+    c->ctrl = irq_quiet ? c->ctrl | DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS : c->ctrl & ~DMA_CH0_CTRL_TRIG_IRQ_QUIET_BITS;
+}
+
+static inline void channel_config_set_ring(dma_channel_config* c, bool write, uint size_bits)
+{
+    c->ctrl = (c->ctrl & ~(DMA_CH0_CTRL_TRIG_RING_SIZE_BITS | DMA_CH0_CTRL_TRIG_RING_SEL_BITS)) |
+              (size_bits << DMA_CH0_CTRL_TRIG_RING_SIZE_LSB) | (write ? DMA_CH0_CTRL_TRIG_RING_SEL_BITS : 0);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config* config, volatile void* write_addr, const volatile void* read_addr,
+                           uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void* read_addr, bool trigger);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+void dma_start_channel_mask(uint32_t mask);
+void dma_channel_abort(uint channel);
+
+#endif
@@ -0,0 +1,18 @@
+/**
+ * Interrupts of the SDK on the host: the handlers are only recorded, the models call them (sdk_stub_irq()).
+ */
+#ifndef HARDWARE_IRQ_H
+#define HARDWARE_IRQ_H
+
+#include "pico/stdlib.h"
+
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define PIO0_IRQ_1 8
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+
+#endif
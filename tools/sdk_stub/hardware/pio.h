@@ -0,0 +1,26 @@
+/**
+ * PIO of the SDK on the host: the TX FIFO registers as targets for the DMA, nothing runs them.
+ */
+#ifndef HARDWARE_PIO_H
+#define HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+
+typedef struct
+{
+    io_wo_32 txf[4];
+} pio_hw_t;
+
+typedef pio_hw_t* PIO;
+
+extern pio_hw_t sdk_stub_pio0;
+#define pio0 (&sdk_stub_pio0)
+
+// DREQ_PIO0_TX0 is 0, the RX ones follow the 4 TX ones.
+static inline uint pio_get_dreq(PIO pio, uint sm, bool is_tx)
+{
+    (void)pio;
+    return (is_tx ? 0 : 4) + sm;
+}
+
+#endif
@@ -0,0 +1,21 @@
+/**
+ * SysTick of the SDK on the host: plain memory, the counter stands still and every measure is 0 cycles.
+ * The host tools time the calls themselves.
+ */
+#ifndef HARDWARE_STRUCTS_SYSTICK_H
+#define HARDWARE_STRUCTS_SYSTICK_H
+
+#include "pico/stdlib.h"
+
+typedef struct
+{
+    io_rw_32 csr;
+    io_rw_32 rvr;
+    io_rw_32 cvr;
+    io_rw_32 calib;
+} systick_hw_t;
+
+extern systick_hw_t sdk_stub_systick;
+#define systick_hw (&sdk_stub_systick)
+
+#endif
@@ -0,0 +1,14 @@
+/**
+ * Barriers of the SDK on the host.
+ */
+#ifndef HARDWARE_SYNC_H
+#define HARDWARE_SYNC_H
+
+#include "pico/stdlib.h"
+
+static inline void __dmb(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#endif
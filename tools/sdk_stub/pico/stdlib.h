@@ -0,0 +1,29 @@
+/**
+ * The little of the Pico SDK the firmware modules the host tools compile need, see sdk_stub.h.
+ */
+#ifndef PICO_STDLIB_H
+#define PICO_STDLIB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+typedef volatile uint32_t io_rw_32;
+typedef volatile uint32_t io_wo_32;
+
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+
+// Everything runs from RAM on the host.
+#define __not_in_flash_func(name) name
+
+void sdk_stub_assert_failed(const char* condition, const char* file, int line);
+#define hard_assert(condition) ((condition) ? (void)0 : sdk_stub_assert_failed(#condition, __FILE__, __LINE__))
+
+// Busy waits of the firmware give the simulated hardware a chance to move, see sdk_stub_set_idle().
+void tight_loop_contents(void);
+
+uint32_t time_us_32(void);
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * Host stand in for the Pico SDK, see sdk_stub.h.
+ */
+#include "sdk_stub.h"
+
+#include "hardware/structs/systick.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+dma_hw_t sdk_stub_dma;
+pio_hw_t sdk_stub_pio0;
+systick_hw_t sdk_stub_systick;
+
+static uint s_claimed = 0;
+static irq_handler_t s_handlers[32];
+static uint32_t s_enabled = 0;
+static void (*s_idle)(void);
+
+void sdk_stub_assert_failed(const char* condition, const char* file, int line)
+{
+    fprintf(stderr, "%s:%d: hard_assert(%s) failed\n", file, line, condition);
+    abort();
+}
+
+void tight_loop_contents(void)
+{
+    if (s_idle)
+    {
+        s_idle();
+    }
+}
+
+uint32_t time_us_32(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+void sdk_stub_set_idle(void (*idle)(void))
+{
+    s_idle = idle;
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler)
+{
+    s_handlers[num] = handler;
+}
+
+void irq_set_enabled(uint num, bool enabled)
+{
+    s_enabled = enabled ? s_enabled | (1u << num) : s_enabled & ~(1u << num);
+}
+
+bool sdk_stub_irq(uint num)
+{
+    if (!(s_enabled & (1u << num)) || !s_handlers[num])
+    {
+        return false;
+    }
+    s_handlers[num]();
+    return true;
+}
+
+int dma_claim_unused_channel(bool required)
+{
+    if (s_claimed == NUM_DMA_CHANNELS)
+    {
+        hard_assert(!required);
+        return -1;
+    }
+    return (int)s_claimed++;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    dma_channel_config config = {DMA_CH0_CTRL_TRIG_EN_BITS};
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_dreq(&config, DREQ_FORCE);
+    channel_config_set_chain_to(&config, channel);
+    return config;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config* config, volatile void* write_addr, const volatile void* read_addr,
+                           uint transfer_count, bool trigger)
+{
+    dma_channel_hw_t* hw = &dma_hw->ch[channel];
+    hw->write_addr = (uintptr_t)write_addr;
+    hw->transfer_count = transfer_count;
+    hw->al1_ctrl = config->ctrl;
+    dma_channel_set_read_addr(channel, read_addr, trigger);
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void* read_addr, bool trigger)
+{
+    dma_channel_hw_t* hw = &dma_hw->ch[channel];
+    hw->read_addr = (uintptr_t)read_addr;
+    hw->ring_start = (uintptr_t)read_addr;
+    if (trigger)
+    {
+        dma_start_channel_mask(1u << channel);
+    }
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled)
+{
+    dma_hw->inte0 = enabled ? dma_hw->inte0 | (1u << channel) : dma_hw->inte0 & ~(1u << channel);
+}
+
+void dma_start_channel_mask(uint32_t mask)
+{
+    for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++)
+    {
+        if ((mask & (1u << channel)) && (dma_hw->ch[channel].al1_ctrl & DMA_CH0_CTRL_TRIG_EN_BITS))
+        {
+            dma_hw->ch[channel].al1_ctrl |= DMA_CH0_CTRL_TRIG_BUSY_BITS;
+        }
+    }
+}
+
+void dma_channel_abort(uint channel)
+{
+    dma_hw->ch[channel].al1_ctrl &= ~DMA_CH0_CTRL_TRIG_BUSY_BITS;
+}
@@ -0,0 +1,23 @@
+/**
+ * Host stand in for the parts of the Pico SDK that display_list.c, framebuffer.c and the other firmware
+ * modules the host tools compile use: the headers in this directory take the place of the SDK ones.
+ *
+ * The registers are plain memory, nothing happens by itself: the tools run models of the hardware
+ * (tools/pio_sim/dma_model.h) which call the interrupt handlers the firmware installed, and busy
+ * waits of the firmware (tight_loop_contents()) call the idle function so the models move on while
+ * the firmware waits for them.
+ */
+#ifndef SDK_STUB_H
+#define SDK_STUB_H
+
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+
+// Called by every tight_loop_contents(), NULL to do nothing.
+void sdk_stub_set_idle(void (*idle)(void));
+
+// Run the handler of irq num if it is enabled, false if it isn't.
+bool sdk_stub_irq(uint num);
+
+#endif
@@ -0,0 +1,186 @@
+/**
+ * The worst lines of sprites.c in RP2040 cycles against the 8000 of a 64 us line at 125 MHz: n
+ * sprites of a width all on the same 16 lines, at odd x, so SPRITES_PER_LINE of them at most are
+ * drawn and the others dropped. sprites.c runs on tools/sdk_stub, which counts what it drew and
+ * dropped, and the cycles come from a model of the Cortex-M0+ (see below), the SysTick of the host
+ * SDK stands still. The host time of the lines, the 99th percentile of the frames, follows.
+ *
+ * Usage: sprites_bench [-n <frames>]
+ *
+ * On the Pico sprites_get_worst_compose_cycles() measures the same with the SysTick of core 1.
+ */
+#include "sprites.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HEIGHT 16
+#define LINE_CYCLES 8000 // 64 us at 125 MHz.
+
+// Cortex-M0+ from RAM without wait states: loads and stores 2 cycles, taken branches 2, the rest 1. Counted on
+// sprites_compose_line() and draw_sprite_row() instruction by instruction, not measured, give or take a quarter.
+#define CYCLES_PER_LINE 40		 // Call, SysTick reads, the counters.
+#define CYCLES_PER_HIDDEN 9		 // A slot of the scan without image.
+#define CYCLES_PER_SCANNED 30	 // A slot with an image, tested against the line.
+#define CYCLES_PER_DRAWN 40		 // Call of draw_sprite_row() and its clipping.
+#define CYCLES_PER_BYTE 14		 // 3 ldrb, bics, orrs, strb and the loop.
+
+static uint8_t s_line[LINE_COUNT] __attribute__((aligned(4)));
+static volatile uint8_t s_sink; // Keeps the lines.
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compare(const void* a, const void* b)
+{
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Cycles of the model for a line of n sprites of the image, every one of them on it and none clipped.
+static uint model_cycles(const struct sprite_image_t* image, uint n)
+{
+    const uint drawn = n < SPRITES_PER_LINE ? n : SPRITES_PER_LINE;
+    return CYCLES_PER_LINE + (SPRITES_MAX - n) * CYCLES_PER_HIDDEN + n * CYCLES_PER_SCANNED +
+           drawn * (CYCLES_PER_DRAWN + image->row_bytes * CYCLES_PER_BYTE);
+}
+
+// Host ns per line of n sprites of the image on lines 0 to HEIGHT - 1, composed frames times: the 99th percentile
+// of the frames. false if sprites.c didn't drop the sprites beyond SPRITES_PER_LINE the model counts.
+static bool measure(const struct sprite_image_t* image, uint n, uint frames, double* ns)
+{
+    for (uint i = 0; i < SPRITES_MAX; i++)
+    {
+        sprites_set(i, image, 1 + 2 * ((i * 8) % ((RES_X - image->width) / 2)), 0);
+        if (i >= n)
+        {
+            sprites_hide(i);
+        }
+    }
+
+    double* times = malloc(frames * sizeof(*times));
+    if (!times)
+    {
+        return false;
+    }
+    const uint32_t dropped = sprites_get_dropped();
+    for (uint frame = 0; frame < frames; frame++)
+    {
+        const double start = now_s();
+        for (uint y = 0; y < HEIGHT; y++)
+        {
+            sprites_compose_line(y, s_line);
+        }
+        times[frame] = (now_s() - start) * 1e9 / HEIGHT;
+        s_sink = s_line[frame % LINE_COUNT];
+    }
+    qsort(times, frames, sizeof(*times), compare);
+    *ns = times[frames * 99 / 100];
+    free(times);
+
+    const uint beyond = n > SPRITES_PER_LINE ? n - SPRITES_PER_LINE : 0;
+    return sprites_get_dropped() - dropped == (uint32_t)beyond * HEIGHT * frames;
+}
+
+int main(int argc, char** argv)
+{
+    uint frames = 2000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            frames = (uint)atoi(argv[++i]);
+            if (frames == 0)
+            {
+                fprintf(stderr, "%s: at least 1 frame\n", argv[i]);
+                return 2;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n <frames>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    static const uint widths[] = {8, 16, 32, 64};
+    static const uint counts[] = {1, 8, SPRITES_PER_LINE, SPRITES_MAX};
+    static const uint width_count = sizeof(widths) / sizeof(widths[0]);
+    static const uint count_count = sizeof(counts) / sizeof(counts[0]);
+    uint cycles[4][4];
+    double ns[4][4];
+
+    for (uint w = 0; w < width_count; w++)
+    {
+        const uint width = widths[w];
+        uint8_t* source = malloc(width * HEIGHT);
+        uint8_t* storage = malloc(SPRITE_IMAGE_BYTES(width, HEIGHT));
+        if (!source || !storage)
+        {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        // Opaque but for the corners.
+        for (uint i = 0; i < width * HEIGHT; i++)
+        {
+            source[i] = (i % width == 0 || i % width == width - 1) && (i / width == 0 || i / width == HEIGHT - 1) ? 0xff : WHITE;
+        }
+        struct sprite_image_t image;
+        sprite_image_pack(&image, storage, source, width, HEIGHT, 0xff);
+
+        for (uint c = 0; c < count_count; c++)
+        {
+            cycles[w][c] = model_cycles(&image, counts[c]);
+            if (!measure(&image, counts[c], frames, &ns[w][c]))
+            {
+                fprintf(stderr, "%u sprites %u wide: not the %u per line the model draws\n", counts[c], width, SPRITES_PER_LINE);
+                return 1;
+            }
+        }
+
+        for (uint i = 0; i < SPRITES_MAX; i++)
+        {
+            sprites_hide(i);
+        }
+        free(storage);
+        free(source);
+    }
+
+    printf("sprites per line: ");
+    for (uint c = 0; c < count_count; c++)
+    {
+        printf("%14u", counts[c]);
+    }
+    printf("   (%u dropped beyond SPRITES_PER_LINE)\n", SPRITES_MAX - SPRITES_PER_LINE);
+    printf("RP2040 cycles of the worst line (model), %% of the %u of a line at 125 MHz:\n", LINE_CYCLES);
+    for (uint w = 0; w < width_count; w++)
+    {
+        printf("%3u pixels wide:  ", widths[w]);
+        for (uint c = 0; c < count_count; c++)
+        {
+            printf("%8u %4.0f%%", cycles[w][c], cycles[w][c] * 100.0 / LINE_CYCLES);
+        }
+        printf("\n");
+    }
+    printf("host ns per line, 99th percentile of %u frames:\n", frames);
+    for (uint w = 0; w < width_count; w++)
+    {
+        printf("%3u pixels wide:  ", widths[w]);
+        for (uint c = 0; c < count_count; c++)
+        {
+            printf("%14.0f", ns[w][c]);
+        }
+        printf("\n");
+    }
+
+    printf("max %u per line, %lu sprite lines dropped\n", sprites_get_max_per_line(), (unsigned long)sprites_get_dropped());
+    return 0;
+}
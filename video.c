@@ -0,0 +1,473 @@
+/**
+ * SCART RGB PAL / NTSC video output, see video.h.
+ */
+#include "video.h"
+
+#include "csync.pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "rgb.pio.h"
+#include "sync.h"
+
+// Border pixels for the 32-bit display list reads, read again on every border line (the whole line with
+// the scroll program).
+static uint16_t s_border = BLACK;
+static uint32_t s_border_color = VIDEO_COLOR_WORD(BLACK);
+
+// The rgb program of the pixel format and the loops of its jmp x-- per line.
+#if VIDEO_COLOR_BITS > 1
+#define RGB_PROGRAM rgb_wide_program
+#define RGB_PROGRAM_INIT(pio, sm, offset, pin, div_int, div_frac)                                                                      \
+    rgb_wide_program_init(pio, sm, offset, pin, VIDEO_RGB_PINS, div_int, div_frac)
+#define RGB_LOOPS (LINE_COUNT / 4) // Words.
+#define RGB_SCROLL_PROGRAM rgb_wide_scroll_program
+#define RGB_SCROLL_PROGRAM_INIT(pio, sm, offset, pin, div_int, div_frac)                                                               \
+    rgb_wide_scroll_program_init(pio, sm, offset, pin, VIDEO_RGB_PINS, div_int, div_frac)
+#elif VIDEO_DENSE_PIXELS
+#define RGB_PROGRAM rgb_dense_program
+#define RGB_PROGRAM_INIT rgb_dense_program_init
+#define RGB_LOOPS (LINE_COUNT / 4) // Words.
+// No room in the instruction memory for a scroll program of 10 pixels per word, video_set_hscroll() says so.
+#define RGB_SCROLL_PROGRAM rgb_dense_program
+#define RGB_SCROLL_PROGRAM_INIT rgb_dense_program_init
+#else
+#define RGB_PROGRAM rgb_program
+#define RGB_PROGRAM_INIT rgb_program_init
+#define RGB_LOOPS LINE_COUNT // Bytes (pixel pairs).
+#define RGB_SCROLL_PROGRAM rgb_scroll_program
+#define RGB_SCROLL_PROGRAM_INIT rgb_scroll_program_init
+#endif
+
+// The loops of the scroll programs are 9 and 10-bit fields of the scroll word.
+#if RES_X > 1024
+#error "RES_X too wide for the scroll programs"
+#endif
+
+static const struct video_mode_t* s_mode;
+static const struct sync_field_t* s_fields; // VIDEO_FIELDS of them.
+
+static struct clock_plan_t s_clock_plan;
+static bool s_clock_in_tolerance;
+
+static uint s_csync_offset;
+static uint s_rgb_offset;
+static bool s_hscroll = false; // The scroll program is loaded instead of the plain one.
+static struct video_scroll_program_t s_scroll_program;
+static bool s_running = false;
+static void (*s_list_builder)(void);
+
+// The sync table the csync state machine runs, sent over and over by s_sync_channel.
+static uint16_t s_sync_table[SYNC_TABLE_SIZE];
+static const uint16_t* s_sync_table_head = s_sync_table;
+
+static uint s_sync_entries;
+
+// Mark entry of each line of the table, and the flags the marks raise (irq 0 starts the pixels).
+static uint16_t s_sync_marks[SYNC_MAX_LINES];
+#define VBLANK_IRQ 1
+#define LINE_IRQ 2
+
+static void (*s_vblank_callback)(void);
+static void (*s_line_callback)(uint y);
+static volatile uint32_t s_field_count = 0;
+
+// Lines asked for, a bit per line, and the ones marked in the table in order. Core 0 only touches the
+// bits, the table follows them at the next vertical blank.
+static volatile uint32_t s_line_irq_bits[(RES_Y + 31) / 32];
+static volatile bool s_line_irqs_changed = false;
+static uint16_t s_line_irqs[RES_Y];
+static uint s_line_irq_count = 0;
+static volatile uint s_next_line_irq = 0; // Index in s_line_irqs of the next one of the field.
+
+static uint s_sync_channel;	   // Send the table.
+static uint s_restart_channel; // Restart the sync channel at the head of the table.
+
+static void sync_dma_init(PIO pio)
+{
+    s_sync_channel = dma_claim_unused_channel(true);
+    s_restart_channel = dma_claim_unused_channel(true);
+
+    {
+        // Halfwords, the bus replicates them in both halves of the FIFO word and csync pulls 16 bits.
+        dma_channel_config cfg = dma_channel_get_default_config(s_sync_channel);
+        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+        channel_config_set_read_increment(&cfg, true);
+        channel_config_set_write_increment(&cfg, false);
+        channel_config_set_dreq(&cfg, pio_get_dreq(pio, CSYNC_SM, true));
+        channel_config_set_chain_to(&cfg, s_restart_channel);
+
+        dma_channel_configure(s_sync_channel, &cfg, &pio->txf[CSYNC_SM], s_sync_table, s_sync_entries, false);
+    }
+
+    {
+        // Same trick as channel 2 of the display list: write the head of the table into the read address trigger.
+        dma_channel_config cfg = dma_channel_get_default_config(s_restart_channel);
+        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+        channel_config_set_read_increment(&cfg, false);
+        channel_config_set_write_increment(&cfg, false);
+
+        dma_channel_configure(s_restart_channel, &cfg, &dma_hw->ch[s_sync_channel].al3_read_addr_trig, &s_sync_table_head, 1,
+                              false);
+    }
+}
+
+// Frequencies of the state machines in mHz.
+static uint64_t csync_mhz(const struct video_mode_t* mode)
+{
+    return (uint64_t)mode->line_mhz * SYNC_LINE_TICS;
+}
+
+static uint64_t rgb_mhz(const struct video_mode_t* mode)
+{
+    // RES_X * 3 cycles in active_ns.
+    return (uint64_t)RES_X * 3 * 1000000000000 / mode->active_ns;
+}
+
+// Point the mark of visible line y (RES_Y: the first line under the picture) of every field at a flag, -1 for none.
+static void set_line_mark(uint y, int irq)
+{
+    uint line = s_mode->border_top_lines + y;
+    for (uint field = 0; field < VIDEO_FIELDS; field++)
+    {
+        sync_set_mark(s_sync_table, s_sync_marks[line], irq);
+        line += s_fields[field].lines;
+    }
+}
+
+// Bring the marks of the visible lines in line with the bits, the beam must not be on the picture.
+static void update_line_marks(void)
+{
+    s_line_irqs_changed = false;
+    s_line_irq_count = 0;
+    for (uint y = 0; y < RES_Y; y++)
+    {
+        const bool on = (s_line_irq_bits[y / 32] >> (y % 32)) & 1;
+        set_line_mark(y, on ? LINE_IRQ : -1);
+        if (on)
+        {
+            s_line_irqs[s_line_irq_count++] = y;
+        }
+    }
+}
+
+// The csync state machine sets the flags of the marks, nothing else clears them.
+static void __not_in_flash_func(mark_irq_handler)(void)
+{
+    PIO pio = VIDEO_PIO;
+
+    if (pio_interrupt_get(pio, LINE_IRQ))
+    {
+        pio_interrupt_clear(pio, LINE_IRQ);
+        const uint index = s_next_line_irq++;
+        if (index < s_line_irq_count && s_line_callback)
+        {
+            s_line_callback(s_line_irqs[index]);
+        }
+    }
+
+    if (pio_interrupt_get(pio, VBLANK_IRQ))
+    {
+        pio_interrupt_clear(pio, VBLANK_IRQ);
+        s_field_count++;
+        s_next_line_irq = 0;
+
+        // Whole field lines away from the picture, the new marks are in place long before it.
+        if (s_line_irqs_changed)
+        {
+            update_line_marks();
+        }
+        if (s_vblank_callback)
+        {
+            s_vblank_callback();
+        }
+    }
+}
+
+// Clock dividers and sync table of the mode, with the state machines and the DMAs stopped.
+// Both state machines from the top of their programs, whatever a stop left in them: pio_sm_init() inside clears
+// the FIFOs, the shift registers and the delays and jumps to the start. csync goes high and the pixels black until
+// the first entries.
+static void init_state_machines(void)
+{
+    PIO pio = VIDEO_PIO;
+
+    const struct clock_plan_t* plan = &s_clock_plan;
+    csync_program_init(pio, CSYNC_SM, s_csync_offset, CSYNC_PIN, plan->csync_div_int, plan->csync_div_frac);
+    if (s_hscroll)
+    {
+        RGB_SCROLL_PROGRAM_INIT(pio, RGB_SM, s_rgb_offset, RED_PIN, plan->rgb_div_int, plan->rgb_div_frac);
+    }
+    else
+    {
+        RGB_PROGRAM_INIT(pio, RGB_SM, s_rgb_offset, RED_PIN, plan->rgb_div_int, plan->rgb_div_frac);
+    }
+    pio_sm_set_pins_with_mask(pio, CSYNC_SM, 1u << CSYNC_PIN, 1u << CSYNC_PIN);
+    pio_sm_set_pins_with_mask(pio, RGB_SM, 0, ((1u << VIDEO_RGB_PINS) - 1) << RED_PIN);
+}
+
+static void configure(const struct video_mode_t* mode)
+{
+    s_mode = mode;
+    s_fields = mode->fields[VIDEO_INTERLACED];
+    init_state_machines();
+
+    // All the sync pulses of a frame.
+    s_sync_entries = sync_build(s_sync_table, SYNC_TABLE_SIZE, mode->timing, s_fields, VIDEO_FIELDS, s_sync_marks);
+    hard_assert(s_sync_entries > 0);
+
+    // The vertical blank starts on the first line under the picture.
+    hard_assert(s_mode->border_top_lines + RES_Y < s_fields[0].lines);
+    set_line_mark(RES_Y, VBLANK_IRQ);
+    update_line_marks();
+}
+
+void video_init(const struct video_mode_t* mode)
+{
+    // The system clock the dividers of the mode come out best from, 125 MHz for the 25 MHz rgb clock of PAL
+    // at 320 pixels.
+    s_clock_in_tolerance = clock_plan_solve(&s_clock_plan, csync_mhz(mode), rgb_mhz(mode), VIDEO_SYS_CLOCK_MIN_HZ,
+                                            VIDEO_SYS_CLOCK_MAX_HZ, VIDEO_CLOCK_PPM);
+    set_sys_clock_pll(s_clock_plan.vco_hz, s_clock_plan.postdiv1, s_clock_plan.postdiv2);
+
+    // Choose which PIO instance to use (there are two instances, each with 4 state machines)
+    PIO pio = VIDEO_PIO;
+
+    // pio program offsets for the cysnc and the rgb.
+    s_csync_offset = pio_add_program(pio, &csync_program);
+    s_rgb_offset = pio_add_program(pio, &RGB_PROGRAM);
+
+    // Initialize each program.
+    configure(mode);
+
+    // Prepare the DMAs to do automatic data transfer.
+    sync_dma_init(pio);
+    display_list_init(pio, RGB_SM, LINE_COUNT);
+
+    // Vertical blank and line interrupts on the core that called video_init().
+    pio_set_irq1_source_enabled(pio, pis_interrupt0 + VBLANK_IRQ, true);
+    pio_set_irq1_source_enabled(pio, pis_interrupt0 + LINE_IRQ, true);
+    irq_set_exclusive_handler(PIO0_IRQ_1, mark_irq_handler);
+    irq_set_enabled(PIO0_IRQ_1, true);
+}
+
+void video_start(void)
+{
+    PIO pio = VIDEO_PIO;
+
+    // After a stop the state machines are wherever they were, with words left in their FIFOs: the csync one in
+    // the middle of the table, the rgb one full, the loops below would never fit.
+    init_state_machines();
+
+    // Fill the csync FIFO with the first entries of the table.
+    dma_channel_set_read_addr(s_sync_channel, s_sync_table, false);
+    dma_channel_set_trans_count(s_sync_channel, s_sync_entries, true);
+
+    // rgb loops with jmp x--, which runs x + 1 times: the bytes (pixel pairs) or words of a line. The scroll
+    // programs take it from the word in front of each line.
+    if (!s_hscroll)
+    {
+        pio_sm_put_blocking(pio, RGB_SM, RGB_LOOPS - 1);
+    }
+
+    // An irq 0 left over from before a stop would start the pixels of the first line right away.
+    pio_interrupt_clear(pio, 0);
+    pio_interrupt_clear(pio, VBLANK_IRQ);
+    pio_interrupt_clear(pio, LINE_IRQ);
+    s_field_count = 0;
+    s_next_line_irq = 0;
+    if (s_line_irqs_changed)
+    {
+        update_line_marks();
+    }
+
+    // Enable the state machines.
+    pio_enable_sm_mask_in_sync(pio, (1u << CSYNC_SM) | (1u << RGB_SM));
+
+    // Start the DMA chain that sends the RGB data.
+    display_list_start();
+    s_running = true;
+}
+
+void video_stop(void)
+{
+    pio_set_sm_mask_enabled(VIDEO_PIO, (1u << CSYNC_SM) | (1u << RGB_SM), false);
+
+    // With the state machines stopped both DMAs stall on their DREQ once the FIFOs are full, so
+    // nothing completes and chains while they are aborted.
+    dma_channel_abort(s_sync_channel);
+    dma_channel_abort(s_restart_channel);
+    display_list_stop();
+    s_running = false;
+}
+
+void video_set_list_builder(void (*build)(void))
+{
+    s_list_builder = build;
+}
+
+void video_set_mode(const struct video_mode_t* mode)
+{
+    const bool running = s_running;
+    if (running)
+    {
+        video_stop();
+    }
+
+    s_clock_in_tolerance = clock_plan_solve_dividers(&s_clock_plan, csync_mhz(mode), rgb_mhz(mode), VIDEO_CLOCK_PPM);
+    configure(mode);
+
+    // The borders depend on the mode.
+    if (s_list_builder)
+    {
+        s_list_builder();
+    }
+
+    if (running)
+    {
+        video_start();
+    }
+}
+
+const struct video_mode_t* video_get_mode(void)
+{
+    return s_mode;
+}
+
+const struct clock_plan_t* video_get_clock_plan(void)
+{
+    return &s_clock_plan;
+}
+
+bool video_clock_in_tolerance(void)
+{
+    return s_clock_in_tolerance;
+}
+
+// Labels of the scroll program loaded at s_rgb_offset, VIDEO_DENSE_PIXELS has none.
+static void set_scroll_program(void)
+{
+#if VIDEO_COLOR_BITS > 1
+    const uint offset = s_rgb_offset;
+    s_scroll_program = (struct video_scroll_program_t){
+        true,
+        offset + rgb_wide_scroll_offset_odd,
+        offset + rgb_wide_scroll_offset_even,
+        offset + rgb_wide_scroll_offset_drain,
+        0,
+        offset + rgb_wide_scroll_offset_blank,
+    };
+#elif !VIDEO_DENSE_PIXELS
+    const uint offset = s_rgb_offset;
+    s_scroll_program = (struct video_scroll_program_t){
+        false,
+        offset + rgb_scroll_offset_odd_drop,
+        offset + rgb_scroll_offset_even_drop,
+        offset + rgb_scroll_offset_drain,
+        offset + rgb_scroll_offset_line,
+        offset + rgb_scroll_offset_blank,
+    };
+#endif
+}
+
+bool video_set_hscroll(bool on)
+{
+    hard_assert(!s_running);
+    if (VIDEO_DENSE_PIXELS || on == s_hscroll)
+    {
+        return on == s_hscroll;
+    }
+
+    PIO pio = VIDEO_PIO;
+    pio_remove_program(pio, s_hscroll ? &RGB_SCROLL_PROGRAM : &RGB_PROGRAM, s_rgb_offset);
+    s_hscroll = on;
+    s_rgb_offset = pio_add_program(pio, s_hscroll ? &RGB_SCROLL_PROGRAM : &RGB_PROGRAM);
+    set_scroll_program();
+    configure(s_mode);
+    video_set_border_color(s_border);
+    return true;
+}
+
+bool video_get_hscroll(void)
+{
+    return s_hscroll;
+}
+
+uint32_t video_get_scroll_word(uint pixels)
+{
+    hard_assert(s_hscroll && pixels < VIDEO_PIXELS_PER_WORD);
+    return video_mode_scroll_word(&s_scroll_program, RES_X, pixels);
+}
+
+uint32_t video_get_color_line_word(uint16_t color)
+{
+    hard_assert(s_hscroll);
+    return video_mode_color_line_word(&s_scroll_program, RES_X, color);
+}
+
+void video_set_border_color(uint16_t color)
+{
+    s_border = color;
+    s_border_color = s_hscroll ? video_get_color_line_word(color) : VIDEO_COLOR_WORD(color);
+}
+
+// A border line is LINE_COUNT bytes of the colour, or a single word with the scroll program.
+static void add_border(struct display_list_t* list, uint lines)
+{
+    if (s_hscroll)
+    {
+        display_list_add_fill(list, &s_border_color, lines);
+    }
+    else
+    {
+        display_list_add_border(list, &s_border_color, lines);
+    }
+}
+
+void video_add_border_top(struct display_list_t* list)
+{
+    add_border(list, s_mode->border_top_lines);
+}
+
+void video_add_border_bottom(struct display_list_t* list, uint field)
+{
+    // Whatever is left of the lines with irq 0 of the field, one more in the first field of interlaced.
+    add_border(list, s_fields[field].lines - s_mode->border_top_lines - RES_Y);
+}
+
+void video_set_vblank_callback(void (*callback)(void))
+{
+    s_vblank_callback = callback;
+}
+
+uint32_t video_get_field_count(void)
+{
+    return s_field_count;
+}
+
+void video_wait_vblank(void)
+{
+    const uint32_t count = s_field_count;
+    while (s_field_count == count)
+    {
+        tight_loop_contents();
+    }
+}
+
+void video_set_line_callback(void (*callback)(uint y))
+{
+    s_line_callback = callback;
+}
+
+void video_add_line_irq(uint y)
+{
+    hard_assert(y < RES_Y);
+    s_line_irq_bits[y / 32] |= 1u << (y % 32);
+    s_line_irqs_changed = true;
+}
+
+void video_remove_line_irq(uint y)
+{
+    hard_assert(y < RES_Y);
+    s_line_irq_bits[y / 32] &= ~(1u << (y % 32));
+    s_line_irqs_changed = true;
+}
@@ -0,0 +1,154 @@
+/**
+ * SCART RGB PAL / NTSC video output.
+ *
+ * Owns the PIO state machines (csync + rgb) and the DMA display list chain that feeds the
+ * rgb state machine. What gets sent is up to the display mode picked between video_init()
+ * and video_start():
+ *  - framebuffer.h: double or triple buffered, scrollable framebuffers.
+ *  - scanline.h: core 1 renders each line just ahead of the beam, no framebuffer at all.
+ *
+ * The line and field timing is a struct video_mode_t (video_mode.h), the clock dividers and the sync table
+ * come from it at runtime and video_set_mode() switches to another one without a reboot.
+ * video_init() picks the system clock that hits the line and pixel frequencies of the mode
+ * best (see clock_plan.h), init stdio after it as the peripheral clock follows.
+ *
+ * The sync table also raises PIO irq flags 1 (vertical blank) and 2 (line interrupts) from
+ * marks in the horizontal blanking of lines (see sync.h), PIO0_IRQ_1 turns them into callbacks.
+ */
+#ifndef VIDEO_H
+#define VIDEO_H
+
+#include "clock_plan.h"
+#include "display_list.h"
+#include "hardware/pio.h"
+#include "pico/stdlib.h"
+#include "pixel_format.h"
+#include "sync.h"
+#include "video_mode.h"
+
+// 1 for 576i / 480i: two fields of 312.5 / 262.5 lines, the second one half a line lower, each
+// showing every other line of a frame of FRAME_Y lines. 0 for the same 312 / 262-line field over and over.
+#ifndef VIDEO_INTERLACED
+#define VIDEO_INTERLACED 0
+#endif
+
+#define VIDEO_FIELDS (VIDEO_INTERLACED ? 2 : 1)
+
+// System clock range video_init() picks from and accuracy wanted for the line and pixel frequencies.
+#ifndef VIDEO_SYS_CLOCK_MIN_HZ
+#define VIDEO_SYS_CLOCK_MIN_HZ 100000000
+#endif
+#ifndef VIDEO_SYS_CLOCK_MAX_HZ
+#define VIDEO_SYS_CLOCK_MAX_HZ 133000000
+#endif
+#ifndef VIDEO_CLOCK_PPM
+#define VIDEO_CLOCK_PPM 10
+#endif
+
+// The picture is the same in every mode (the buffers are sized for it), the modes place it. 640 or
+// 720 pixels wide make 80 or 90 columns of 8 pixel text, the pixel clock of the modes follows: 160 wide
+// the rgb state machine runs at half the clock of 320, each pixel lasts twice as long.
+#ifndef RES_X
+#define RES_X 320
+#endif
+
+#if RES_X % VIDEO_PIXELS_PER_WORD
+#error "RES_X must be a whole number of 32-bit words of pixels, a multiple of 8 (10 with VIDEO_DENSE_PIXELS)"
+#endif
+#define RES_Y 240 // Lines of a field.
+
+// Lines showing each row of the framebuffer mode: 2 for 120 rows (240 interlaced), the display list sends every row
+// twice. With RES_X 160 that is 160x120 in a quarter of the memory of 320x240, room for a third buffer (see
+// framebuffer.h). The other modes go by lines, the line table of raster.h can repeat rows too.
+#ifndef VIDEO_LINE_REPEAT
+#define VIDEO_LINE_REPEAT 1
+#endif
+#if VIDEO_LINE_REPEAT < 1 || RES_Y % VIDEO_LINE_REPEAT
+#error "VIDEO_LINE_REPEAT must divide RES_Y"
+#endif
+#define FRAME_Y (RES_Y * VIDEO_FIELDS / VIDEO_LINE_REPEAT) // Rows of a whole picture.
+
+#define LINE_COUNT (RES_X / VIDEO_PIXELS_PER_WORD * 4) // Bytes of a line.
+
+// PIO instance and state machines used.
+#define VIDEO_PIO pio0
+#define CSYNC_SM 0
+#define RGB_SM 1
+
+// I/O pins used. The 15 pins of 5-5-5 don't fit above 18, multi-bit colour starts at GPIO 0 (stdio
+// over USB then, the UART pins are taken).
+#ifndef CSYNC_PIN
+#define CSYNC_PIN 16
+#endif
+#ifndef RED_PIN
+#define RED_PIN (VIDEO_COLOR_BITS > 1 ? 0 : 18)
+#endif
+#define GREEN_PIN (RED_PIN + VIDEO_COLOR_BITS)
+#define BLUE_PIN (RED_PIN + 2 * VIDEO_COLOR_BITS)
+
+// Set the clocks, load the csync and rgb programs, build the sync table of the mode and prepare the DMA chains.
+void video_init(const struct video_mode_t* mode);
+
+// System clock and dividers in use, with the error achieved. video_set_mode() keeps the system clock
+// of video_init() and only picks new dividers, so the error may be larger.
+const struct clock_plan_t* video_get_clock_plan(void);
+
+// True if both the line and the pixel frequencies are within VIDEO_CLOCK_PPM.
+bool video_clock_in_tolerance(void);
+
+// Enable the state machines and start sending the sync table and the display list shown.
+void video_start(void);
+
+// Stop the state machines and the DMA chains, video_start() starts again from the top of a frame.
+void video_stop(void);
+
+// Display modes register how to build their display lists, video_set_mode() calls it for the new borders.
+void video_set_list_builder(void (*build)(void));
+
+// Switch to another mode without a reboot: stop, reconfigure the state machines and the sync
+// table, rebuild the display lists and start again in sync. Between video_init() and video_start()
+// it just reconfigures.
+void video_set_mode(const struct video_mode_t* mode);
+
+const struct video_mode_t* video_get_mode(void);
+
+// Called from an interrupt at the start of the vertical blank of every field, right after the last line of the
+// picture: the bottom border, the vertical sync and the top border go by before the next one.
+void video_set_vblank_callback(void (*callback)(void));
+
+// Fields since video_start(), counted at each vertical blank: interlaced, the field being sent is the count & 1.
+uint32_t video_get_field_count(void);
+
+// Block until the next vertical blank starts.
+void video_wait_vblank(void);
+
+// Called from an interrupt in the horizontal blanking before each visible line (0 to RES_Y - 1 of a field) added
+// with video_add_line_irq(), 11 us before its pixels (5 us in the wide modes). The pixels of the line are already
+// on their way to the rgb state machine, a change shows from the next line on.
+void video_set_line_callback(void (*callback)(uint y));
+
+// Interrupt at line y from the next vertical blank on, any number of lines.
+void video_add_line_irq(uint y);
+void video_remove_line_irq(uint y);
+
+// Colour of the top and bottom borders, the DMA picks it up from the next border line.
+void video_set_border_color(uint16_t color);
+
+// Fine horizontal scroll: load the rgb program that starts each line up to VIDEO_PIXELS_PER_WORD - 1 pixels into
+// its first word (rgb_scroll in rgb.pio), the DMA read address takes care of whole words. A line is then the
+// word of video_get_scroll_word() followed by LINE_COUNT + 4 bytes of pixels, a line of a single colour (borders
+// too) is the one word of video_get_color_line_word(). Only with the state machines stopped, false if the pixel
+// format has no scroll program (VIDEO_DENSE_PIXELS). The modes other than raster.h expect it off.
+bool video_set_hscroll(bool on);
+bool video_get_hscroll(void);
+
+// Words in front of a line that skips the first pixels of its first word, and of a line of a colour. They depend
+// on where the program got loaded.
+uint32_t video_get_scroll_word(uint pixels);
+uint32_t video_get_color_line_word(uint16_t color);
+
+// Append the border lines above / below the picture of a field (0 or 1) to a display list.
+void video_add_border_top(struct display_list_t* list);
+void video_add_border_bottom(struct display_list_t* list, uint field);
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * Video modes and scroll words, see video_mode.h.
+ */
+#include "video_mode.h"
+
+#include <string.h>
+
+// The pixels take 38.4 us, or 46 us in the wide modes, where they start earlier: a 25 MHz rgb clock
+// for 320 pixels, 50 / 41.7 MHz for 640.
+#define ACTIVE_NS 38400
+#define WIDE_ACTIVE_NS 46080
+static const struct sync_timing_t s_pal_wide_timing = {5, 30, 2, 12};
+static const struct sync_timing_t s_ntsc_wide_timing = {5, 27, 2, 12};
+
+// 15.625 kHz and 4.5 MHz / 286 = 15.734 kHz.
+#define PAL_LINE_MHZ 15625000
+#define NTSC_LINE_MHZ 15734266
+
+const struct video_mode_t video_mode_pal = {
+    "pal", &sync_pal_timing, {sync_pal_progressive, sync_pal_interlaced}, PAL_LINE_MHZ, ACTIVE_NS, 42,
+};
+
+const struct video_mode_t video_mode_pal_wide = {
+    "pal_wide", &s_pal_wide_timing, {sync_pal_progressive, sync_pal_interlaced}, PAL_LINE_MHZ, WIDE_ACTIVE_NS, 42,
+};
+
+const struct video_mode_t video_mode_ntsc = {
+    "ntsc", &sync_ntsc_timing, {sync_ntsc_progressive, sync_ntsc_interlaced}, NTSC_LINE_MHZ, ACTIVE_NS, 11,
+};
+
+const struct video_mode_t video_mode_ntsc_wide = {
+    "ntsc_wide", &s_ntsc_wide_timing, {sync_ntsc_progressive, sync_ntsc_interlaced}, NTSC_LINE_MHZ, WIDE_ACTIVE_NS, 11,
+};
+
+const struct video_mode_t* const video_modes[VIDEO_MODE_COUNT] = {
+    &video_mode_pal,
+    &video_mode_pal_wide,
+    &video_mode_ntsc,
+    &video_mode_ntsc_wide,
+};
+
+const struct video_mode_t* video_mode_find(const char* name)
+{
+    for (unsigned i = 0; i < VIDEO_MODE_COUNT; i++)
+    {
+        if (strcmp(video_modes[i]->name, name) == 0)
+        {
+            return video_modes[i];
+        }
+    }
+    return NULL;
+}
+
+uint32_t video_mode_scroll_word(const struct video_scroll_program_t* program, unsigned res_x, unsigned pixels)
+{
+    if (program->wide)
+    {
+        // An odd pixel dropped leaves one halfword of the extra word to drain instead of two.
+        const unsigned entry = pixels ? program->odd : program->even;
+        return entry | (program->drain + pixels) << 5 | (res_x / 2 - 1) << 10;
+    }
+
+    // Whole bytes are dropped from the end of a chain of 3, an odd pixel with the chain that drops the first
+    // pixel of the next byte too. The extra word gives what the line takes past its bytes, the rest of it is
+    // drained.
+    const unsigned bytes = pixels / 2;
+    const unsigned used = (pixels + 1) / 2;
+    const unsigned entry = (pixels & 1) ? program->odd : program->even;
+    const unsigned drain = used < 4 ? program->drain + used : program->line;
+    return drain | (res_x - 1) << 5 | (entry + 3 - bytes) << 15;
+}
+
+uint32_t video_mode_color_line_word(const struct video_scroll_program_t* program, unsigned res_x, uint32_t code)
+{
+    if (program->wide)
+    {
+        return program->blank | code << 5 | (res_x - 2) << 21;
+    }
+    return code | (res_x - 2) << 5 | program->blank << 15;
+}
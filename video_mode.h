@@ -0,0 +1,57 @@
+/**
+ * The video modes and the words in front of the lines of the scroll programs.
+ *
+ * A struct video_mode_t is the line and field timing video_init() and video_set_mode() set up,
+ * the scroll and colour line words are what rgb_scroll / rgb_wide_scroll (rgb.pio) take in front
+ * of each line, see video_set_hscroll().
+ *
+ * Plain C without the SDK so tools/pio_sim runs the very same modes and words.
+ */
+#ifndef VIDEO_MODE_H
+#define VIDEO_MODE_H
+
+#include "sync.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Everything about the timing of a mode.
+struct video_mode_t
+{
+    const char* name;
+    const struct sync_timing_t* timing;	  // Sync pulses and where the pixels start (the back porch), in csync tics.
+    const struct sync_field_t* fields[2]; // Progressive and interlaced, the one VIDEO_INTERLACED picks is used.
+    uint32_t line_mhz;					  // Line frequency in mHz, 64 csync tics per line.
+    uint32_t active_ns;					  // Width of the RES_X pixels, 3 rgb cycles each.
+    uint16_t border_top_lines;			  // The bottom border is what is left of the field.
+};
+
+extern const struct video_mode_t video_mode_pal;	   // 312 lines, 50 Hz.
+extern const struct video_mode_t video_mode_pal_wide;  // Same, with wider pixels filling the visible width.
+extern const struct video_mode_t video_mode_ntsc;	   // 262 lines, 60 Hz, 15.734 kHz.
+extern const struct video_mode_t video_mode_ntsc_wide; // Same, with wider pixels.
+
+#define VIDEO_MODE_COUNT 4
+extern const struct video_mode_t* const video_modes[VIDEO_MODE_COUNT];
+
+// The mode of that name, NULL if none.
+const struct video_mode_t* video_mode_find(const char* name);
+
+// Where the labels of the scroll program of the pixel format are in the instruction memory, the load offset added.
+struct video_scroll_program_t
+{
+    bool wide;		// rgb_wide_scroll, halfword pixels. rgb_scroll otherwise, 2 pixels a byte.
+    uint8_t odd;	// odd / odd_drop.
+    uint8_t even;	// even / even_drop.
+    uint8_t drain;	// drain.
+    uint8_t line;	// line, rgb_scroll only.
+    uint8_t blank;	// blank.
+};
+
+// Word in front of a line of res_x pixels that skips the first pixels of its first word (up to 7, or 1 wide).
+uint32_t video_mode_scroll_word(const struct video_scroll_program_t* program, unsigned res_x, unsigned pixels);
+
+// Word of a whole line of res_x pixels of one pin code.
+uint32_t video_mode_color_line_word(const struct video_scroll_program_t* program, unsigned res_x, uint32_t code);
+
+#endif